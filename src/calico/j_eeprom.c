@@ -28,6 +28,7 @@
 
 #include "../elib/elib.h"
 #include "../elib/misc.h"
+#include "../elib/trace.h"
 #include "../hal/hal_ml.h"
 #include "../hal/hal_platform.h"
 #include "j_eeprom.h"
@@ -137,6 +138,7 @@ void ReadEEProm(void)
 {
    int i;
    uint16_t checksum;
+   TRACE_BEGIN(trace);
 
    checksum = 12345;
 
@@ -150,6 +152,7 @@ void ReadEEProm(void)
    if(checksum != eeprombuffer[EEWORDS-1])
    {
       ClearEEProm();
+      TRACE_END(trace, "ReadEEProm");
       return;
    }
 
@@ -171,6 +174,8 @@ void ReadEEProm(void)
    maxlevel = eeprombuffer[6];
    if(maxlevel < 1 || maxlevel > 25)
       maxlevel = 1;
+
+   TRACE_END(trace, "ReadEEProm");
 }
 
 void WriteEEProm(void)
@@ -22,6 +22,7 @@
 
 #include "textscreen.h"
 #include "../elib/elib.h"
+#include "../elib/dircache.h"
 #include "../hal/hal_platform.h"
 #include "m_misc.h"
 
@@ -47,73 +48,22 @@ boolean M_FileExists(const char *filename)
     }
 }
 
-// Check if a file exists by probing for common case variation of its filename.
+// Check if a file exists, whatever the case of its filename. An exact
+// match is preferred; otherwise the file is found through the cached
+// listing of its directory, rather than by probing for each common case
+// variation of its name.
 // Returns a newly allocated string that the caller is responsible for freeing.
 
 char *M_FileCaseExists(const char *path)
 {
-    char *path_dup, *filename, *ext;
-
-    path_dup = M_StringDuplicate(path);
-
-    // 0: actual path
-    if (M_FileExists(path_dup))
-    {
-        return path_dup;
-    }
-
-    filename = strrchr(path_dup, DIR_SEPARATOR);
-    if (filename != NULL)
-    {
-        filename++;
-    }
-    else
-    {
-        filename = path_dup;
-    }
-
-    // 1: lowercase filename, e.g. doom2.wad
-    M_ForceLowercase(filename);
-
-    if (M_FileExists(path_dup))
-    {
-        return path_dup;
-    }
-
-    // 2: uppercase filename, e.g. DOOM2.WAD
-    M_ForceUppercase(filename);
-
-    if (M_FileExists(path_dup))
-    {
-        return path_dup;
-    }
-
-    // 3. uppercase basename with lowercase extension, e.g. DOOM2.wad
-    ext = strrchr(path_dup, '.');
-    if (ext != NULL && ext > filename)
-    {
-        M_ForceLowercase(ext + 1);
-
-        if (M_FileExists(path_dup))
-        {
-            return path_dup;
-        }
-    }
+    char *result;
 
-    // 4. lowercase filename with uppercase first letter, e.g. Doom2.wad
-    if (strlen(filename) > 1)
+    if (E_DirCacheFind(path, &result) == DIRCACHE_NONE)
     {
-        M_ForceLowercase(filename + 1);
-
-        if (M_FileExists(path_dup))
-        {
-            return path_dup;
-        }
+        return NULL;
     }
 
-    // 5. no luck
-    free(path_dup);
-    return NULL;
+    return result;
 }
 
 // Returns the path to a temporary file of the given name, stored
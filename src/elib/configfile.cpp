@@ -28,13 +28,23 @@
 
 #include "elib.h"
 #include <map>
+#include <thread>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "../hal/hal_platform.h"
 #include "../hal/hal_ml.h"
 #include "atexit.h"
 #include "configfile.h"
+#include "m_argv.h"
 #include "parser.h"
 #include "qstring.h"
+#include "trace.h"
 
 //=============================================================================
 //
@@ -317,8 +327,88 @@ bool CfgFileParser::doStateExpectValue(Tokenizer &token)
 // External Interface
 //
 
+#ifndef _WIN32
+//
+// Read the whole of a file descriptor, from its start. Returns false on
+// an error.
+//
+static bool ReadWholeFd(int fd, qstring &out)
+{
+   struct stat st;
+   char    buf[4096];
+   ssize_t len;
+
+   // Shared memory can't be read() on every system, but can be mapped.
+   if(!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+   {
+      size_t size = static_cast<size_t>(st.st_size);
+      void  *mem  = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(mem != MAP_FAILED)
+      {
+         out.copy(static_cast<const char *>(mem), size);
+         munmap(mem, size);
+         return true;
+      }
+   }
+
+   if(lseek(fd, 0, SEEK_SET) < 0 && errno != ESPIPE)
+      return false;
+
+   while((len = read(fd, buf, sizeof(buf) - 1)) != 0)
+   {
+      if(len < 0)
+      {
+         if(errno == EINTR)
+            continue;
+         return false;
+      }
+      buf[len] = '\0';
+      out << buf;
+   }
+
+   return true;
+}
+#endif
+
+//
+// Load the configuration from a file descriptor handed to us by the
+// process that started us, as given by -cfgfd. Returns false if there is
+// none, in which case the configuration file should be loaded as usual.
+//
+static bool Cfg_LoadHandoff(void)
+{
+   int p = M_GetArgParameters("-cfgfd", 1);
+   if(!p)
+      return false;
+
+#ifdef _WIN32
+   hal_platform.debugMsg("Warning: -cfgfd is not supported on this platform\n");
+   return false;
+#else
+   int fd = atoi(myargv[p]);
+   qstring text;
+   bool ok = ReadWholeFd(fd, text);
+
+   close(fd);
+
+   if(!ok)
+   {
+      hal_platform.debugMsg("Warning: could not read config from fd %d\n", fd);
+      return false;
+   }
+
+   Cfg_LoadBuffer(text.constPtr(), text.length());
+   return true;
+#endif
+}
+
 void Cfg_LoadFile(void)
 {
+   TRACE_SCOPE("Cfg_LoadFile");
+
+   if(Cfg_LoadHandoff())
+      return;
+
    qstring fn(hal_medialayer.getWriteDirectory(ELIB_APPNAME));
    fn.pathConcatenate("calico.cfg");
    CfgFileParser parser(fn.constPtr());
@@ -328,6 +418,16 @@ void Cfg_LoadFile(void)
    //E_AtExit(Cfg_WriteFile, false);
 }
 
+//
+// Load configuration from text held in memory, in the same format as
+// the configuration file.
+//
+void Cfg_LoadBuffer(const char *data, size_t len)
+{
+   CfgFileParser parser("<buffer>");
+   parser.parseBuffer(data, len);
+}
+
 struct cfgwritedata_t
 {
    std::map<qstring, CfgItem *> *itemMap;
@@ -339,28 +439,46 @@ static void AddItemToMap(CfgItem *item, void *data)
    cwd->itemMap->emplace(qstring(item->getName()), item);
 }
 
-static bool WriteCfgItem(CfgItem *item, FILE *f)
+static void WriteCfgItem(CfgItem *item, qstring &out)
 {
    qstring value;
    item->writeItem(value);
-   if(std::fprintf(f, "%s \"%s\"\n", item->getName(), value.constPtr()) < 0)
-      return false;
-   return true;
+   out << item->getName() << " \"" << value << "\"\n";
 }
 
-void Cfg_WriteFile(void)
+//
+// Serialize the current configuration, in the format of the configuration
+// file.
+//
+void Cfg_WriteBuffer(qstring &out)
 {
    cfgwritedata_t cwd;
-   FILE *f     = nullptr;
-   bool  error = false;
    std::map<qstring, CfgItem *> items;
+
+   cwd.itemMap = &items;
+
+   out << "// CALICO configuration file\n";
+
+   // add config items to the map
+   CfgItem::ItemIterator(AddItemToMap, &cwd);
+
+   for(auto &item : items)
+      WriteCfgItem(item.second, out);
+}
+
+//
+// Write serialized configuration to calico.cfg. It is written to a
+// temporary file first so that an error cannot leave a truncated file.
+//
+static void WriteBufferToFile(const qstring &text)
+{
+   FILE *f = nullptr;
    qstring tmpName(hal_medialayer.getWriteDirectory(ELIB_APPNAME));
    qstring dstName(hal_medialayer.getWriteDirectory(ELIB_APPNAME));
 
    tmpName.pathConcatenate("temp.cfg");
    dstName.pathConcatenate("calico.cfg");
 
-   cwd.itemMap = &items;
    f = hal_platform.fileOpen(tmpName.constPtr(), "w");
    if(!f)
    {
@@ -368,25 +486,7 @@ void Cfg_WriteFile(void)
       return;
    }
 
-   if(std::fprintf(f, "// CALICO configuration file\n") < 0)
-   {
-      hal_platform.debugMsg("Warning: failed write to temp.cfg\n");
-      return;
-   }
-
-   // add config items to the map
-   CfgItem::ItemIterator(AddItemToMap, &cwd);
-
-   for(auto &item : items)
-   {
-      if(!WriteCfgItem(item.second, f))
-      {
-         error = true;
-         break;
-      }
-   }
-
-   if(error)
+   if(std::fwrite(text.constPtr(), 1, text.length(), f) != text.length())
    {
       std::fclose(f);
       hal_platform.debugMsg("Warning: failed one or more cfg writes\n");
@@ -404,5 +504,49 @@ void Cfg_WriteFile(void)
       hal_platform.debugMsg("Warning: failed to write calico.cfg\n");
 }
 
+// background writer started by Cfg_WriteFileAsync
+static std::thread asyncWriter;
+
+void Cfg_WriteFile(void)
+{
+   qstring text;
+   Cfg_WriteBuffer(text);
+
+   Cfg_FinishWrite();
+   WriteBufferToFile(text);
+}
+
+//
+// Write the configuration file in the background. The configuration is
+// serialized before returning, so it may be changed straight away.
+//
+void Cfg_WriteFileAsync(void)
+{
+   static bool atExitAdded;
+   qstring text;
+
+   Cfg_WriteBuffer(text);
+
+   // only one write at a time, so that they land in order
+   Cfg_FinishWrite();
+
+   if(!atExitAdded)
+   {
+      E_AtExit(Cfg_FinishWrite, true);
+      atExitAdded = true;
+   }
+
+   asyncWriter = std::thread([text] { WriteBufferToFile(text); });
+}
+
+//
+// Wait for a background write of the configuration file to finish.
+//
+void Cfg_FinishWrite(void)
+{
+   if(asyncWriter.joinable())
+      asyncWriter.join();
+}
+
 // EOF
 
@@ -29,6 +29,8 @@
 #ifndef CONFIG_H__
 #define CONFIG_H__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 
 #include "compare.h"
@@ -86,11 +88,16 @@ public:
    static void ItemIterator(void (*func)(CfgItem *, void *), void *data);
 };
 
+void Cfg_WriteBuffer(qstring &out);
+
 extern "C" {
 #endif
 
 void Cfg_LoadFile();
+void Cfg_LoadBuffer(const char *data, size_t len);
 void Cfg_WriteFile();
+void Cfg_WriteFileAsync();
+void Cfg_FinishWrite();
 
 #ifdef __cplusplus
 }
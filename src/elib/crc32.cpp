@@ -0,0 +1,151 @@
+/*
+  CALICO
+  
+  CRC-32 checksums
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include "elib.h"
+#include "crc32.h"
+
+static const uint32_t CRC32_POLY = 0xEDB88320u; // reflected
+
+//
+// Lookup table for bytewise calculation
+//
+struct crc32table_t
+{
+   uint32_t table[256];
+
+   crc32table_t()
+   {
+      for(uint32_t i = 0; i < 256; i++)
+      {
+         uint32_t c = i;
+         for(int k = 0; k < 8; k++)
+            c = (c & 1) ? (c >> 1) ^ CRC32_POLY : (c >> 1);
+         table[i] = c;
+      }
+   }
+};
+
+//
+// Get the lookup table, building it on first use.
+//
+static const uint32_t *CRC32Table()
+{
+   static const crc32table_t crc32Table;
+   return crc32Table.table;
+}
+
+//
+// Calculate the CRC of a block of data, continuing from a previous CRC.
+//
+uint32_t E_CRC32(uint32_t crc, const void *data, size_t len)
+{
+   auto p     = static_cast<const uint8_t *>(data);
+   auto table = CRC32Table();
+
+   crc = ~crc;
+   while(len--)
+      crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+   return ~crc;
+}
+
+//
+// CRC combination works by treating the effect of appending zero bits to
+// the first block's CRC as a linear operator over GF(2), represented as a
+// 32x32 bit matrix. Squaring the matrix doubles the number of zeros, so
+// the first CRC can be advanced by len2 bytes of zeros in O(log len2)
+// steps; the second block's CRC is then simply xor'ed in.
+//
+
+static uint32_t GF2MatrixTimes(const uint32_t *mat, uint32_t vec)
+{
+   uint32_t sum = 0;
+
+   while(vec)
+   {
+      if(vec & 1)
+         sum ^= *mat;
+      vec >>= 1;
+      mat++;
+   }
+
+   return sum;
+}
+
+static void GF2MatrixSquare(uint32_t *square, const uint32_t *mat)
+{
+   for(int n = 0; n < 32; n++)
+      square[n] = GF2MatrixTimes(mat, mat[n]);
+}
+
+uint32_t E_CRC32Combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+   uint32_t even[32]; // even-power-of-two zeros operator
+   uint32_t odd[32];  // odd-power-of-two zeros operator
+
+   if(len2 == 0)
+      return crc1;
+
+   // put operator for one zero bit in odd
+   odd[0] = CRC32_POLY;
+   uint32_t row = 1;
+   for(int n = 1; n < 32; n++)
+   {
+      odd[n] = row;
+      row <<= 1;
+   }
+
+   // put operator for two zero bits in even, then four in odd
+   GF2MatrixSquare(even, odd);
+   GF2MatrixSquare(odd, even);
+
+   // apply len2 zeros to crc1 (first square puts the operator for one
+   // zero byte, eight zero bits, in even)
+   do
+   {
+      GF2MatrixSquare(even, odd);
+      if(len2 & 1)
+         crc1 = GF2MatrixTimes(even, crc1);
+      len2 >>= 1;
+
+      if(!len2)
+         break;
+
+      GF2MatrixSquare(odd, even);
+      if(len2 & 1)
+         crc1 = GF2MatrixTimes(odd, crc1);
+      len2 >>= 1;
+   }
+   while(len2);
+
+   return crc1 ^ crc2;
+}
+
+// EOF
+
@@ -0,0 +1,289 @@
+/*
+  CALICO
+  
+  Cached directory listings
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+//
+// Each directory that is looked into is read once, and its entries are
+// kept in a hash map keyed by their lower-cased names, so that a file can
+// be found whatever the case of its name without probing the filesystem
+// for each spelling. A listing is reused for as long as the directory's
+// modification time is unchanged; as that time may have a coarse
+// granularity, a listing read within a second of the directory changing
+// is not trusted, and is read again next time.
+//
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "elib.h"
+#include "dircache.h"
+#include "qstring.h"
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+//
+// Windows file systems ignore case anyway.
+//
+int E_DirCacheFind(const char *path, char **realPath)
+{
+   int type = E_DirCacheExists(path);
+
+   if(type != DIRCACHE_NONE && realPath)
+      *realPath = estrdup(path);
+
+   return type;
+}
+
+int E_DirCacheExists(const char *path)
+{
+   DWORD attribs = GetFileAttributesA(path);
+
+   if(attribs == INVALID_FILE_ATTRIBUTES)
+      return DIRCACHE_NONE;
+
+   return (attribs & FILE_ATTRIBUTE_DIRECTORY) ? DIRCACHE_DIR : DIRCACHE_FILE;
+}
+
+#else
+
+enum
+{
+   DIRCACHE_UNKNOWN = -1 // must be stat'ed, eg. a symbolic link
+};
+
+struct direntry_t
+{
+   qstring name;
+   int     type;
+};
+
+struct dirlisting_t
+{
+   long long mtime;
+   bool      stable;
+
+   // entries by lower-cased name
+   std::unordered_map<qstring, std::vector<direntry_t>, qstring::hash> entries;
+};
+
+static std::mutex dirCacheMutex;
+static std::unordered_map<qstring, dirlisting_t, qstring::hash> dirCache;
+
+//
+// Get a modification time, in nanoseconds where it is available.
+//
+static long long ModTime(const struct stat &st)
+{
+#if defined(__APPLE__)
+   return st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+   return st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+   return st.st_mtime * 1000000000LL;
+#endif
+}
+
+static int StatType(const char *path)
+{
+   struct stat st;
+
+   if(stat(path, &st))
+      return DIRCACHE_NONE;
+
+   return S_ISDIR(st.st_mode) ? DIRCACHE_DIR : DIRCACHE_FILE;
+}
+
+//
+// Look up a path as it is spelled.
+//
+static int StatPath(const char *path, char **realPath)
+{
+   int type = StatType(path);
+
+   if(type != DIRCACHE_NONE && realPath)
+      *realPath = estrdup(path);
+
+   return type;
+}
+
+static bool ReadListing(const qstring &dir, dirlisting_t &listing,
+                        const struct stat &st)
+{
+   DIR *d;
+   struct dirent *ent;
+
+   listing.entries.clear();
+   listing.mtime  = ModTime(st);
+   listing.stable = time(nullptr) > st.st_mtime + 1;
+
+   if(!(d = opendir(dir.constPtr())))
+      return false;
+
+   while((ent = readdir(d)))
+   {
+      direntry_t entry;
+
+      if(!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+         continue;
+
+      entry.name = ent->d_name;
+      entry.type = DIRCACHE_UNKNOWN;
+#ifdef DT_DIR
+      if(ent->d_type == DT_DIR)
+         entry.type = DIRCACHE_DIR;
+      else if(ent->d_type == DT_REG)
+         entry.type = DIRCACHE_FILE;
+#endif
+
+      qstring key(ent->d_name);
+      listing.entries[key.toLower()].push_back(entry);
+   }
+
+   closedir(d);
+   return true;
+}
+
+//
+// Find an entry in the cached listing of its directory. If exact is
+// false, a name matching exactly is still preferred.
+//
+static int FindEntry(const char *path, bool exact, char **realPath)
+{
+   qstring fullPath(path);
+   qstring dir, name;
+   struct stat st;
+   size_t slash;
+
+   fullPath.normalizeSlashes();
+
+   if((slash = fullPath.findLastOf('/')) == qstring::npos)
+   {
+      dir  = ".";
+      name = fullPath;
+   }
+   else
+   {
+      dir.copy(fullPath.constPtr(), slash ? slash : 1);
+      name = fullPath.constPtr() + slash + 1;
+   }
+
+   // Paths that do not end in a name are left to the file system.
+   if(name.empty() || name == "." || name == "..")
+      return StatPath(path, realPath);
+
+   std::lock_guard<std::mutex> guard(dirCacheMutex);
+
+   if(stat(dir.constPtr(), &st) || !S_ISDIR(st.st_mode))
+   {
+      dirCache.erase(dir);
+      return DIRCACHE_NONE;
+   }
+
+   auto it = dirCache.find(dir);
+
+   if(it == dirCache.end() || !it->second.stable ||
+      it->second.mtime != ModTime(st))
+   {
+      dirlisting_t &listing = dirCache[dir];
+
+      // A directory that can be searched but not listed still has files
+      // that can be opened by their exact names.
+      if(!ReadListing(dir, listing, st))
+      {
+         dirCache.erase(dir);
+         return StatPath(path, realPath);
+      }
+      it = dirCache.find(dir);
+   }
+
+   qstring key(name);
+   auto match = it->second.entries.find(key.toLower());
+
+   if(match == it->second.entries.end())
+      return DIRCACHE_NONE;
+
+   const direntry_t *entry = nullptr;
+
+   for(const direntry_t &candidate : match->second)
+   {
+      if(candidate.name == name)
+      {
+         entry = &candidate;
+         break;
+      }
+   }
+
+   if(!entry)
+   {
+      if(exact)
+         return DIRCACHE_NONE;
+      entry = &match->second.front();
+   }
+
+   // not pathConcatenate, which would take "//name" for a UNC path
+   qstring found(dir);
+   if(dir != "/")
+      found += '/';
+   found += entry->name;
+
+   int type = entry->type;
+   if(type == DIRCACHE_UNKNOWN)
+      type = StatType(found.constPtr());
+
+   if(type == DIRCACHE_NONE)
+      return DIRCACHE_NONE;
+
+   if(realPath)
+      *realPath = estrdup(slash == qstring::npos ? entry->name.constPtr()
+                                                  : found.constPtr());
+
+   return type;
+}
+
+int E_DirCacheFind(const char *path, char **realPath)
+{
+   return FindEntry(path, false, realPath);
+}
+
+int E_DirCacheExists(const char *path)
+{
+   return FindEntry(path, true, nullptr);
+}
+
+#endif
+
+// EOF
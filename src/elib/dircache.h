@@ -0,0 +1,62 @@
+/*
+  CALICO
+  
+  Cached directory listings
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef DIRCACHE_H__
+#define DIRCACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+   DIRCACHE_NONE,
+   DIRCACHE_FILE,
+   DIRCACHE_DIR
+};
+
+//
+// Look up a file or directory, ignoring the case of the last component of
+// its path. Returns one of the values above. If it exists and realPath is
+// not NULL, a newly allocated copy of the path, with the name spelled as
+// it is in the directory, is returned through it.
+//
+int E_DirCacheFind(const char *path, char **realPath);
+
+//
+// Look up a file or directory whose name matches exactly.
+//
+int E_DirCacheExists(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// EOF
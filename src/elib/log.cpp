@@ -0,0 +1,336 @@
+/*
+  CALICO
+  
+  Asynchronous logging
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+//
+// Messages pass from any number of threads to a single writer thread
+// through a bounded queue of fixed-size slots (after Dmitry Vyukov's
+// bounded MPMC queue). A producer claims a slot by advancing the enqueue
+// position, formats its message straight into it, and then publishes it
+// by storing the slot's sequence number; the writer takes published slots
+// in order and hands them back. Nobody takes a lock or waits on anybody
+// else, and when the writer falls behind, messages are counted and
+// dropped rather than holding up the thread that logged them.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "elib.h"
+#include "atexit.h"
+#include "log.h"
+#include "m_argv.h"
+#include "misc.h"
+#include "qstring.h"
+#include "../hal/hal_ml.h"
+#include "../hal/hal_platform.h"
+
+// Number of queue slots; must be a power of two.
+static const size_t LOG_QUEUE_SIZE = 1024;
+
+// Messages longer than this are truncated.
+static const size_t LOG_MESSAGE_SIZE = 240;
+
+// The log is rotated when it grows past this size, keeping this many
+// older logs.
+static const long LOG_MAX_FILE_SIZE = 1024 * 1024;
+static const int  LOG_MAX_OLD_FILES = 3;
+
+// How often the writer looks for new messages.
+static const std::chrono::milliseconds LOG_FLUSH_INTERVAL(50);
+
+struct logslot_t
+{
+   std::atomic<size_t> sequence;
+   loglevel_t          level;
+   const char         *category;
+   uint64_t            time;
+   char                text[LOG_MESSAGE_SIZE];
+};
+
+int e_logLevel = LOGLEVEL_NONE;
+
+static logslot_t           logQueue[LOG_QUEUE_SIZE];
+static std::atomic<size_t> logEnqueuePos;
+static size_t              logDequeuePos; // writer thread only
+static std::atomic<size_t> logDropped;
+static uint64_t            logEpoch;
+
+static qstring                 logFileName;
+static FILE                   *logFile;
+static std::thread             logThread;
+static std::mutex              logMutex;
+static std::condition_variable logCond;
+static bool                    logStopping;
+
+static const char *const logLevelNames[] = { "debug", "info", "warning", "error" };
+
+//
+// Monotonic clock, in milliseconds
+//
+static uint64_t LogClock()
+{
+   return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void E_LogV(loglevel_t level, const char *category, const char *fmt, va_list args)
+{
+   logslot_t *slot;
+   size_t     pos;
+
+   if(level < e_logLevel)
+      return;
+
+   pos = logEnqueuePos.load(std::memory_order_relaxed);
+   for(;;)
+   {
+      slot = &logQueue[pos & (LOG_QUEUE_SIZE - 1)];
+
+      size_t    seq  = slot->sequence.load(std::memory_order_acquire);
+      ptrdiff_t diff = static_cast<ptrdiff_t>(seq - pos);
+
+      if(diff == 0)
+      {
+         if(logEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+      }
+      else if(diff < 0)
+      {
+         // Full; the writer has yet to take the slot from the last time round
+         logDropped.fetch_add(1, std::memory_order_relaxed);
+         return;
+      }
+      else
+         pos = logEnqueuePos.load(std::memory_order_relaxed);
+   }
+
+   slot->level    = level;
+   slot->category = category;
+   slot->time     = LogClock() - logEpoch;
+   pvsnprintf(slot->text, sizeof(slot->text), fmt, args);
+
+   slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void E_Log(loglevel_t level, const char *category, const char *fmt, ...)
+{
+   va_list args;
+
+   va_start(args, fmt);
+   E_LogV(level, category, fmt, args);
+   va_end(args);
+}
+
+//
+// Move the log aside to make room for a new one
+//
+static void RotateLog()
+{
+   qstring from, to;
+
+   if(logFile)
+   {
+      std::fclose(logFile);
+      logFile = nullptr;
+   }
+
+   for(int i = LOG_MAX_OLD_FILES; i > 0; i--)
+   {
+      to = logFileName;
+      to << "." << i;
+      if(i > 1)
+      {
+         from = logFileName;
+         from << "." << (i - 1);
+      }
+      else
+         from = logFileName;
+
+      std::remove(to.constPtr());
+      std::rename(from.constPtr(), to.constPtr());
+   }
+}
+
+//
+// Write out everything that has been published so far
+//
+static void DrainQueue()
+{
+   bool   wrote = false;
+   size_t dropped;
+
+   if(!logFile)
+      return;
+
+   for(;;)
+   {
+      logslot_t *slot = &logQueue[logDequeuePos & (LOG_QUEUE_SIZE - 1)];
+
+      if(slot->sequence.load(std::memory_order_acquire) != logDequeuePos + 1)
+         break;
+
+      size_t len = std::strlen(slot->text);
+      while(len > 0 && slot->text[len - 1] == '\n')
+         --len;
+
+      std::fprintf(logFile, "%6u.%03u %-7s %s: %.*s\n",
+                   static_cast<unsigned int>(slot->time / 1000),
+                   static_cast<unsigned int>(slot->time % 1000),
+                   logLevelNames[slot->level], slot->category,
+                   static_cast<int>(len), slot->text);
+
+      slot->sequence.store(logDequeuePos + LOG_QUEUE_SIZE, std::memory_order_release);
+      ++logDequeuePos;
+      wrote = true;
+   }
+
+   if((dropped = logDropped.exchange(0, std::memory_order_relaxed)))
+   {
+      std::fprintf(logFile, "(%u messages dropped)\n", static_cast<unsigned int>(dropped));
+      wrote = true;
+   }
+
+   if(!wrote)
+      return;
+
+   std::fflush(logFile);
+
+   if(std::ftell(logFile) > LOG_MAX_FILE_SIZE)
+   {
+      RotateLog();
+      logFile = hal_platform.fileOpen(logFileName.constPtr(), "w");
+   }
+}
+
+static void LogWriter()
+{
+   std::unique_lock<std::mutex> lock(logMutex);
+
+   while(!logStopping)
+   {
+      lock.unlock();
+      DrainQueue();
+      lock.lock();
+      logCond.wait_for(lock, LOG_FLUSH_INTERVAL, [] { return logStopping; });
+   }
+}
+
+//
+// Stop the writer thread, after it has written out everything logged
+// before the call.
+//
+static void E_LogStop(void)
+{
+   {
+      std::lock_guard<std::mutex> guard(logMutex);
+      logStopping = true;
+   }
+   logCond.notify_one();
+
+   if(logThread.joinable())
+      logThread.join();
+
+   DrainQueue();
+
+   if(logFile)
+   {
+      std::fclose(logFile);
+      logFile = nullptr;
+   }
+}
+
+//
+// Look up a level by name; an unknown name means "info".
+//
+static int LevelForName(const char *name)
+{
+   for(size_t i = 0; i < earrlen(logLevelNames); i++)
+   {
+      if(!strcasecmp(name, logLevelNames[i]))
+         return static_cast<int>(i);
+   }
+
+   return LOGLEVEL_INFO;
+}
+
+void E_LogInit(void)
+{
+   const char *env;
+   int         p;
+
+   if(e_logLevel != LOGLEVEL_NONE)
+      return;
+
+   //!
+   // @arg [level]
+   //
+   // Write a log to calico-config.log in the configuration directory.
+   // The level is debug, info, warning or error, and defaults to info.
+   // The CALICO_LOG environment variable can be set to a level instead.
+   //
+
+   if(M_FindArgument("-log"))
+   {
+      p = M_GetArgParameters("-log", 1);
+      e_logLevel = LevelForName(p > 0 && myargv[p][0] != '-' ? myargv[p] : "");
+   }
+   else if((env = std::getenv("CALICO_LOG")) && *env)
+      e_logLevel = LevelForName(env);
+   else
+      return;
+
+   for(size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+      logQueue[i].sequence.store(i, std::memory_order_relaxed);
+
+   logEpoch = LogClock();
+
+   logFileName = hal_medialayer.getWriteDirectory(ELIB_APPNAME);
+   logFileName.pathConcatenate("calico-config.log");
+
+   RotateLog();
+   if(!(logFile = hal_platform.fileOpen(logFileName.constPtr(), "w")))
+   {
+      e_logLevel = LOGLEVEL_NONE;
+      hal_platform.debugMsg("E_LogInit: cannot write %s\n", logFileName.constPtr());
+      return;
+   }
+
+   logThread = std::thread(LogWriter);
+
+   E_AtExit(E_LogStop, true);
+
+   E_Log(LOGLEVEL_INFO, "log", "Logging at level %s", logLevelNames[e_logLevel]);
+}
+
+// EOF
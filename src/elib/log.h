@@ -0,0 +1,84 @@
+/*
+  CALICO
+  
+  Asynchronous logging
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef LOG_H__
+#define LOG_H__
+
+#include <stdarg.h>
+
+typedef enum
+{
+   LOGLEVEL_DEBUG,
+   LOGLEVEL_INFO,
+   LOGLEVEL_WARNING,
+   LOGLEVEL_ERROR,
+   LOGLEVEL_NONE    // logging is off
+} loglevel_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Lowest level of message that is logged. Only set by E_LogInit, before
+// any other threads are started.
+//
+extern int e_logLevel;
+
+//
+// Turn logging on if asked for with -log [level] or the CALICO_LOG
+// environment variable, which holds a level name. Messages are written
+// by a background thread to a log file in the configuration directory,
+// which is rotated when it grows too large.
+//
+void E_LogInit(void);
+
+//
+// Log a message. Formatting happens on the calling thread, but nothing
+// else does; the message is placed in a lock-free queue, or dropped if
+// the queue is full, so that no thread ever waits for the log file.
+// The category must be a string literal.
+//
+void E_Log(loglevel_t level, const char *category, const char *fmt, ...);
+void E_LogV(loglevel_t level, const char *category, const char *fmt,
+            va_list args);
+
+#ifdef __cplusplus
+}
+#endif
+
+//
+// Log a message, without evaluating the arguments if it would not be
+// logged.
+//
+#define E_LOG(level, category, ...) \
+   do { if((level) >= e_logLevel) E_Log(level, category, __VA_ARGS__); } while(0)
+
+#endif
+
+// EOF
@@ -233,6 +233,20 @@ int Tokenizer::getNextToken()
 
 // Parse a single file.
 void Parser::parseFile()
+{
+   parseData(M_LoadStringFromFile(m_filename));
+}
+
+// Parse text held in memory. The text need not be null-terminated.
+void Parser::parseBuffer(const char *data, size_t len)
+{
+   char *text = ecalloc(char, 1, len + 1);
+   std::memcpy(text, data, len);
+   parseData(text);
+}
+
+// Parse loaded text; the parser takes ownership of it.
+void Parser::parseData(char *data)
 {
    // free any previously loaded data
    if(m_data)
@@ -241,11 +255,14 @@ void Parser::parseFile()
       m_data = nullptr;
    }
 
-   char *file = M_LoadStringFromFile(m_filename);
-   if(estrempty(file))
+   if(estrempty(data))
+   {
+      if(data)
+         efree(data);
       return; // can't parse an empty file
+   }
 
-   m_data = file;
+   m_data = data;
    startFile();
 
    Tokenizer tokenizer(m_data);
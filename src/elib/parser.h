@@ -123,6 +123,8 @@ protected:
    // Called when EOF is reached
    virtual void onEOF(bool early) {}
 
+   void parseData(char *data);
+
 public:
    Parser(const char *filename)
       : m_filename(filename), m_data(nullptr)
@@ -139,6 +141,7 @@ public:
    }
 
    void parseFile();
+   void parseBuffer(const char *data, size_t len);
 };
 
 #endif
@@ -0,0 +1,227 @@
+/*
+  CALICO
+  
+  Span tracing
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+//
+// Spans are recorded into a fixed-size buffer belonging to the thread
+// that records them, so recording takes no locks: only the first span
+// on each thread takes the lock, to register its buffer. A buffer's
+// event count is published with release semantics, so the events can
+// be written out at exit while other threads are still recording.
+//
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "elib.h"
+#include "atexit.h"
+#include "qstring.h"
+#include "trace.h"
+#include "../hal/hal_platform.h"
+
+#if CALICO_TRACE
+
+// Spans beyond this many on one thread are dropped.
+static const size_t TRACE_BUFFER_EVENTS = 65536;
+
+struct traceevent_t
+{
+   const char *name;
+   uint64_t    start;
+   uint64_t    duration;
+};
+
+struct tracebuffer_t
+{
+   int                 tid;
+   std::atomic<size_t> count;
+   std::atomic<size_t> dropped;
+   traceevent_t        events[TRACE_BUFFER_EVENTS];
+};
+
+static std::atomic<bool>            traceEnabled;
+static uint64_t                     traceEpoch;
+static qstring                      traceFile;
+static std::mutex                   traceMutex;
+static std::vector<tracebuffer_t *> traceBuffers;
+
+static thread_local tracebuffer_t *threadBuffer;
+
+//
+// Monotonic clock, in nanoseconds
+//
+static uint64_t TraceClock()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//
+// Get the calling thread's buffer, creating it on first use. Buffers are
+// kept until exit, as their threads may finish before the trace is written.
+//
+static tracebuffer_t *GetThreadBuffer()
+{
+   if(!threadBuffer)
+   {
+      auto buffer = new tracebuffer_t;
+
+      buffer->count   = 0;
+      buffer->dropped = 0;
+
+      std::lock_guard<std::mutex> guard(traceMutex);
+      buffer->tid = static_cast<int>(traceBuffers.size()) + 1;
+      traceBuffers.push_back(buffer);
+      threadBuffer = buffer;
+   }
+
+   return threadBuffer;
+}
+
+uint64_t E_TraceBegin(void)
+{
+   return traceEnabled.load(std::memory_order_relaxed) ? TraceClock() : 0;
+}
+
+void E_TraceEnd(const char *name, uint64_t start)
+{
+   if(!start)
+      return;
+
+   uint64_t       end    = TraceClock();
+   tracebuffer_t *buffer = GetThreadBuffer();
+   size_t         n      = buffer->count.load(std::memory_order_relaxed);
+
+   if(n == TRACE_BUFFER_EVENTS)
+   {
+      buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   buffer->events[n] = { name, start, end - start };
+   buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void E_TraceStart(const char *filename)
+{
+   if(traceEnabled)
+      return;
+
+   traceFile  = filename;
+   traceEpoch = TraceClock();
+   traceEnabled = true;
+
+   E_AtExit(E_TraceWrite, true);
+}
+
+//
+// Write a string as a JSON string literal
+//
+static void WriteJSONString(FILE *f, const char *str)
+{
+   fputc('"', f);
+   for(; *str; str++)
+   {
+      if(*str == '"' || *str == '\\')
+         fputc('\\', f);
+      if(static_cast<unsigned char>(*str) >= 0x20)
+         fputc(*str, f);
+   }
+   fputc('"', f);
+}
+
+void E_TraceWrite(void)
+{
+   FILE *f;
+   bool  first = true;
+
+   if(!traceEnabled.exchange(false))
+      return;
+
+   if(!(f = hal_platform.fileOpen(traceFile.constPtr(), "w")))
+   {
+      hal_platform.debugMsg("E_TraceWrite: cannot write %s\n", traceFile.constPtr());
+      return;
+   }
+
+   fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+
+   std::lock_guard<std::mutex> guard(traceMutex);
+
+   for(tracebuffer_t *buffer : traceBuffers)
+   {
+      size_t count = buffer->count.load(std::memory_order_acquire);
+
+      for(size_t i = 0; i < count; i++)
+      {
+         const traceevent_t &ev = buffer->events[i];
+
+         fputs(first ? "" : ",\n", f);
+         fputs("{\"name\":", f);
+         WriteJSONString(f, ev.name);
+         fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 buffer->tid, (ev.start - traceEpoch) / 1000.0,
+                 ev.duration / 1000.0);
+         first = false;
+      }
+
+      if(buffer->dropped)
+      {
+         hal_platform.debugMsg("E_TraceWrite: thread %d dropped %d spans\n",
+                               buffer->tid, static_cast<int>(buffer->dropped));
+      }
+   }
+
+   fputs("\n]}\n", f);
+   fclose(f);
+}
+
+#else
+
+void E_TraceStart(const char *filename)
+{
+   hal_platform.debugMsg("Tracing is not compiled in\n");
+}
+
+void E_TraceWrite(void)
+{
+}
+
+uint64_t E_TraceBegin(void)
+{
+   return 0;
+}
+
+void E_TraceEnd(const char *name, uint64_t start)
+{
+}
+
+#endif
+
+// EOF
@@ -0,0 +1,108 @@
+/*
+  CALICO
+  
+  Span tracing
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef TRACE_H__
+#define TRACE_H__
+
+#include <stdint.h>
+
+//
+// Compile-time kill switch: when CALICO_TRACE is 0, the trace macros
+// compile to nothing, and E_TraceStart does nothing.
+//
+#ifndef CALICO_TRACE
+#define CALICO_TRACE 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Start recording spans, to be written to the given file at exit in the
+// trace event format read by chrome://tracing and Perfetto.
+//
+void E_TraceStart(const char *filename);
+
+//
+// Write out the trace now, and stop recording.
+//
+void E_TraceWrite(void);
+
+//
+// Mark the start and end of a span. Spans are only recorded while
+// tracing; otherwise, E_TraceBegin returns 0 and E_TraceEnd does nothing.
+// The name must be a string literal, or otherwise outlive the trace.
+//
+uint64_t E_TraceBegin(void);
+void     E_TraceEnd(const char *name, uint64_t start);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if CALICO_TRACE
+
+#define TRACE_BEGIN(var)      uint64_t var = E_TraceBegin()
+#define TRACE_END(var, name)  E_TraceEnd(name, var)
+
+#ifdef __cplusplus
+
+//
+// Record a span covering the rest of the enclosing scope.
+//
+class ETraceScope
+{
+   const char *name;
+   uint64_t    start;
+
+public:
+   explicit ETraceScope(const char *pName) : name(pName), start(E_TraceBegin())
+   {
+   }
+
+   ~ETraceScope() { E_TraceEnd(name, start); }
+};
+
+#define TRACE_CONCAT2(a, b)   a ## b
+#define TRACE_CONCAT(a, b)    TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name)     ETraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif
+
+#else
+
+#define TRACE_BEGIN(var)
+#define TRACE_END(var, name)
+#define TRACE_SCOPE(name)
+
+#endif
+
+#endif
+
+// EOF
@@ -0,0 +1,348 @@
+/*
+  CALICO
+  
+  Memory-mapped WAD file reader
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "elib.h"
+#include "binary.h"
+#include "wadfile.h"
+
+static const size_t WAD_HEADER_SIZE = 12;
+static const size_t WAD_DIRENT_SIZE = 16;
+
+// Largest file that is searched for an embedded WAD. Jaguar cartridges
+// are at most 6 MB.
+static const size_t WAD_MAX_ROM_SIZE = 8 * 1024 * 1024;
+
+struct wadfile_s
+{
+   const byte *map;     // whole file
+   size_t      mapsize;
+   const byte *base;    // start of the WAD within the file
+   size_t      size;    // size of the WAD
+   const byte *dir;     // lump directory
+   size_t      numlumps;
+   wadtype_t   type;
+   int         flags;
+};
+
+//=============================================================================
+//
+// File mapping
+//
+
+#ifdef _WIN32
+
+static const byte *MapFile(const char *path, size_t &size)
+{
+   HANDLE        file, mapping;
+   LARGE_INTEGER filesize;
+   void         *view = nullptr;
+
+   file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if(file == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+   if(GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0 &&
+      static_cast<unsigned long long>(filesize.QuadPart) <= SIZE_MAX)
+   {
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if(mapping != nullptr)
+      {
+         view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+         CloseHandle(mapping);
+      }
+      size = static_cast<size_t>(filesize.QuadPart);
+   }
+
+   // the view keeps the file open
+   CloseHandle(file);
+
+   return static_cast<const byte *>(view);
+}
+
+static void UnmapFile(const byte *map, size_t)
+{
+   UnmapViewOfFile(map);
+}
+
+#else
+
+static const byte *MapFile(const char *path, size_t &size)
+{
+   struct stat st;
+   void *map = MAP_FAILED;
+   int fd;
+
+   if((fd = open(path, O_RDONLY)) < 0)
+      return nullptr;
+
+   if(!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0 &&
+      static_cast<unsigned long long>(st.st_size) <= SIZE_MAX)
+   {
+      size = static_cast<size_t>(st.st_size);
+      map  = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   }
+
+   // the mapping keeps the file open
+   close(fd);
+
+   return map != MAP_FAILED ? static_cast<const byte *>(map) : nullptr;
+}
+
+static void UnmapFile(const byte *map, size_t size)
+{
+   munmap(const_cast<byte *>(map), size);
+}
+
+#endif
+
+//=============================================================================
+//
+// Validation
+//
+
+static uint32_t ReadField(const wadfile_t *wad, const byte *data)
+{
+   return (wad->flags & WAD_BIGENDIAN) ? read32_be(data, uint32_t)
+                                       : read32_le(data, uint32_t);
+}
+
+//
+// Check that the directory, as read with the byte order given in the
+// WAD's flags, lies within the WAD.
+//
+static bool DirectoryFits(const wadfile_t *wad)
+{
+   uint64_t numlumps = ReadField(wad, wad->base + 4);
+   uint64_t dirofs   = ReadField(wad, wad->base + 8);
+
+   return dirofs >= WAD_HEADER_SIZE &&
+          dirofs + numlumps * WAD_DIRENT_SIZE <= wad->size;
+}
+
+//
+// Validate the header of a WAD at wad->base, and find its directory.
+// Jaguar WADs are big-endian; the byte order is taken to be whichever
+// one places the directory inside the file.
+//
+static waderror_t ReadHeader(wadfile_t *wad)
+{
+   if(wad->size < WAD_HEADER_SIZE)
+      return WAD_ERR_NOTWAD;
+
+   if(!memcmp(wad->base, "IWAD", 4))
+      wad->type = WAD_IWAD;
+   else if(!memcmp(wad->base, "PWAD", 4))
+      wad->type = WAD_PWAD;
+   else
+      return WAD_ERR_NOTWAD;
+
+   if(!DirectoryFits(wad))
+   {
+      wad->flags ^= WAD_BIGENDIAN;
+      if(!DirectoryFits(wad))
+      {
+         wad->flags ^= WAD_BIGENDIAN;
+         return WAD_ERR_DIRECTORY;
+      }
+   }
+
+   wad->numlumps = ReadField(wad, wad->base + 4);
+   wad->dir      = wad->base + ReadField(wad, wad->base + 8);
+
+   return WAD_OK;
+}
+
+//
+// Check that every lump lies within the WAD. The size of a compressed
+// Jaguar lump is its uncompressed size, so only its offset is checked.
+//
+static waderror_t CheckLumps(const wadfile_t *wad)
+{
+   const byte *entry = wad->dir;
+
+   for(size_t i = 0; i < wad->numlumps; i++, entry += WAD_DIRENT_SIZE)
+   {
+      uint64_t offset = ReadField(wad, entry);
+      uint64_t size   = ReadField(wad, entry + 4);
+
+      if((wad->flags & WAD_BIGENDIAN) && (entry[8] & 0x80))
+         size = 0;
+
+      if(offset + size > wad->size)
+         return WAD_ERR_LUMP;
+   }
+
+   return WAD_OK;
+}
+
+//
+// A Jaguar cartridge image has no header of its own; look for a valid
+// big-endian IWAD within it.
+//
+static bool FindWadInROM(wadfile_t *wad)
+{
+   if(wad->mapsize > WAD_MAX_ROM_SIZE)
+      return false;
+
+   for(size_t ofs = 0; ofs + WAD_HEADER_SIZE <= wad->mapsize; ofs += 4)
+   {
+      if(memcmp(wad->map + ofs, "IWAD", 4))
+         continue;
+
+      wad->base  = wad->map + ofs;
+      wad->size  = wad->mapsize - ofs;
+      wad->flags = WAD_BIGENDIAN | WAD_INROM;
+
+      if(DirectoryFits(wad) && ReadHeader(wad) == WAD_OK &&
+         CheckLumps(wad) == WAD_OK)
+         return true;
+   }
+
+   return false;
+}
+
+//=============================================================================
+//
+// Interface
+//
+
+wadfile_t *Wad_Open(const char *path, waderror_t *error)
+{
+   wadfile_t *wad = estructalloc(wadfile_t, 1);
+   waderror_t err;
+
+   if(!(wad->map = MapFile(path, wad->mapsize)))
+      err = WAD_ERR_OPEN;
+   else
+   {
+      wad->base = wad->map;
+      wad->size = wad->mapsize;
+
+      if((err = ReadHeader(wad)) == WAD_OK)
+         err = CheckLumps(wad);
+      else if(err == WAD_ERR_NOTWAD && FindWadInROM(wad))
+         err = WAD_OK;
+   }
+
+   if(error)
+      *error = err;
+
+   if(err != WAD_OK)
+   {
+      Wad_Close(wad);
+      wad = nullptr;
+   }
+
+   return wad;
+}
+
+void Wad_Close(wadfile_t *wad)
+{
+   if(!wad)
+      return;
+
+   if(wad->map)
+      UnmapFile(wad->map, wad->mapsize);
+   efree(wad);
+}
+
+waderror_t Wad_Check(const char *path)
+{
+   waderror_t err;
+
+   Wad_Close(Wad_Open(path, &err));
+
+   return err;
+}
+
+wadtype_t Wad_Type(const wadfile_t *wad)
+{
+   return wad->type;
+}
+
+int Wad_Flags(const wadfile_t *wad)
+{
+   return wad->flags;
+}
+
+size_t Wad_NumLumps(const wadfile_t *wad)
+{
+   return wad->numlumps;
+}
+
+void Wad_GetLump(const wadfile_t *wad, size_t index, wadlump_t *lump)
+{
+   const byte *entry = wad->dir + index * WAD_DIRENT_SIZE;
+
+   lump->offset = ReadField(wad, entry);
+   lump->size   = ReadField(wad, entry + 4);
+   memcpy(lump->name, entry + 8, 8);
+   lump->name[8] = '\0';
+
+   // Jaguar marks compressed lumps with the high bit of the name
+   lump->compressed = 0;
+   if(wad->flags & WAD_BIGENDIAN)
+   {
+      lump->compressed = (lump->name[0] & 0x80) != 0;
+      lump->name[0] &= 0x7f;
+   }
+}
+
+const void *Wad_LumpData(const wadfile_t *wad, size_t index)
+{
+   const byte *entry = wad->dir + index * WAD_DIRENT_SIZE;
+
+   return wad->base + ReadField(wad, entry);
+}
+
+const char *Wad_ErrorString(waderror_t error)
+{
+   switch(error)
+   {
+   case WAD_OK:            return "OK";
+   case WAD_ERR_OPEN:      return "The file could not be opened";
+   case WAD_ERR_NOTWAD:    return "Not a WAD file";
+   case WAD_ERR_DIRECTORY: return "The lump directory is damaged";
+   case WAD_ERR_LUMP:      return "The file is truncated";
+   }
+
+   return "Unknown error";
+}
+
+// EOF
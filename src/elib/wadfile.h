@@ -0,0 +1,104 @@
+/*
+  CALICO
+  
+  Memory-mapped WAD file reader
+  
+  The MIT License (MIT)
+  
+  Copyright (c) 2016 James Haley
+  
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+  
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+  
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef WADFILE_H__
+#define WADFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+   WAD_OK,
+   WAD_ERR_OPEN,      // could not be opened or mapped
+   WAD_ERR_NOTWAD,    // no IWAD or PWAD header
+   WAD_ERR_DIRECTORY, // lump directory lies outside of the file
+   WAD_ERR_LUMP       // a lump lies outside of the file
+} waderror_t;
+
+typedef enum
+{
+   WAD_IWAD,
+   WAD_PWAD
+} wadtype_t;
+
+// Layout flags
+enum
+{
+   WAD_BIGENDIAN = 0x01, // header and directory are big-endian (Jaguar)
+   WAD_INROM     = 0x02  // WAD is embedded in a Jaguar cartridge image
+};
+
+typedef struct wadlump_s
+{
+   char     name[9];    // NUL-terminated, without the compression bit
+   uint32_t offset;     // from the start of the WAD
+   uint32_t size;       // uncompressed size
+   int      compressed; // Jaguar LZSS-compressed lump
+} wadlump_t;
+
+typedef struct wadfile_s wadfile_t;
+
+//
+// Map a WAD, or a Jaguar ROM containing one, and validate its header and
+// lump directory. Only the pages holding the header and directory are
+// touched. Returns NULL and sets *error if the file is not valid.
+//
+wadfile_t  *Wad_Open(const char *path, waderror_t *error);
+void        Wad_Close(wadfile_t *wad);
+
+//
+// Validate a file without keeping it open.
+//
+waderror_t  Wad_Check(const char *path);
+
+wadtype_t   Wad_Type(const wadfile_t *wad);
+int         Wad_Flags(const wadfile_t *wad);
+size_t      Wad_NumLumps(const wadfile_t *wad);
+
+//
+// Lump directory access. The data pointer refers directly to the mapped
+// file and remains valid until the WAD is closed; compressed lumps are
+// returned as they are stored.
+//
+void        Wad_GetLump(const wadfile_t *wad, size_t index, wadlump_t *lump);
+const void *Wad_LumpData(const wadfile_t *wad, size_t index);
+
+const char *Wad_ErrorString(waderror_t error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// EOF
@@ -32,6 +32,8 @@
 #include <sys/stat.h>
 
 #include "../elib/elib.h"
+#include "../elib/dircache.h"
+#include "../elib/log.h"
 #include "../elib/misc.h"
 #include "../elib/qstring.h"
 #include "../hal/hal_ml.h"
@@ -46,6 +48,15 @@ using namespace std;
 //
 static void POSIX_DebugMsg(const char *msg, ...)
 {
+   if(e_logLevel <= LOGLEVEL_INFO)
+   {
+      va_list args;
+      va_start(args, msg);
+      E_LogV(LOGLEVEL_INFO, "debug", msg, args);
+      va_end(args);
+      return;
+   }
+
 #ifdef _DEBUG
    static FILE *error_log;
 
@@ -131,6 +142,12 @@ static FILE *POSIX_FileOpen(const char *path, const char *mode)
 static hal_bool POSIX_FileExists(const char *path)
 {
     struct stat st;
+
+    if (E_DirCacheExists(path) == DIRCACHE_FILE)
+        return HAL_TRUE;
+
+    // The cache only matches names exactly, but the file system may
+    // ignore case, as on macOS.
     qstring normpath { path };
     normpath.normalizeSlashes();
 
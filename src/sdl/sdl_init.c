@@ -39,11 +39,14 @@
 static hal_bool isExiting;
 
 //
-// Initialize the SDL 2 library
+// Initialize the SDL 2 library. Subsystems are started by their users
+// when they are first needed, rather than all up front: video by
+// TXT_Init, and joystick and game controller support by the dialogs
+// that use them. Nothing needs audio.
 //
 hal_bool SDL2_Init(void)
 {
-   if(SDL_Init(SDL_INIT_EVERYTHING) != 0)
+   if(SDL_Init(0) != 0)
       return HAL_FALSE;
 
    atexit(SDL_Quit);
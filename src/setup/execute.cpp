@@ -23,21 +23,28 @@
 
 #else
 
-#include <sys/wait.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #endif
 
+#include <chrono>
+#include <climits>
 #include <memory>
 #include <vector>
 #include <string>
 
 #include "textscreen.h"
 #include "../elib/elib.h"
+#include "../elib/configfile.h"
 #include "../elib/m_argv.h"
+#include "../elib/misc.h"
 #include "../elib/qstring.h"
 #include "execute.h"
 #include "mode.h"
+#include "prefetch.h"
 #include "m_misc.h"
 
 using args_t = std::vector<qstring>;
@@ -45,8 +52,28 @@ using args_t = std::vector<qstring>;
 struct execute_context_s
 {
     args_t args;
+    int cfg_fd = -1; // configuration handed to the game, or -1
 };
 
+// Output of the most recently launched game, for the log window. Only
+// the end of the output is kept, and overlong lines are wrapped.
+
+#define LAUNCH_LOG_SIZE  65536
+#define LAUNCH_LOG_WIDTH 200
+
+static qstring      launch_log;
+static size_t       launch_log_column;
+static bool         launch_started;
+static bool         launch_running;
+static int          launch_exit_status;
+static unsigned int launch_spawn_time;
+
+// How much of the IWAD and PWADs was in memory when the game started.
+
+static bool               launch_have_cached;
+static unsigned long long launch_cached;
+static unsigned long long launch_cached_total;
+
 // Returns the path to a temporary file of the given name, stored
 // inside the system temporary directory.
 
@@ -117,121 +144,164 @@ void AddCmdLineParameter(execute_context_t *context, const char *s, ...)
     va_end(args);
 }
 
-#if defined(_WIN32)
+//
+// Configuration handoff
+//
+// With -cfghandoff, the configuration is given to the game in memory when
+// it is launched, through a file descriptor named by -cfgfd, so that it
+// does not have to wait for the configuration file to be written and
+// read back. The file is still written, but in the background.
+//
+// -cfgstandin launches this program in place of the game, as a stand-in
+// consumer that prints the configuration it was given.
+//
 
-boolean OpenFolder(const char *path)
+#if !defined(_WIN32)
+
+// Whether the game can be trusted to read the configuration from -cfgfd.
+// A game that does not ignores it and loads calico.cfg instead.
+
+static bool UseConfigHandoff(void)
 {
-    // "If the function succeeds, it returns a value greater than 32."
-    return intptr_t(ShellExecute(nullptr, "open", path, nullptr, nullptr, SW_SHOWDEFAULT)) > 32;
+    return M_FindArgument("-cfghandoff") || M_FindArgument("-cfgstandin");
 }
 
-// Wait for the specified process to exit.  Returns the exit code.
-static unsigned int WaitForProcessExit(HANDLE subprocess)
+// Create a memory file holding the current configuration. Where
+// possible it is sealed, so the game can trust that it won't change.
+
+static int CreateConfigHandoff(void)
 {
-    DWORD exit_code;
+    qstring text;
+    void *mem;
+    int fd = -1;
+    bool sealable = false;
 
-    for (;;)
+    Cfg_WriteBuffer(text);
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+    fd = memfd_create("calico.cfg", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    sealable = (fd >= 0);
+#endif
+
+    if (fd < 0)
     {
-        WaitForSingleObject(subprocess, INFINITE);
+        // Fall back to POSIX shared memory. The name is removed at once,
+        // so that only the descriptor refers to it.
 
-        if (!GetExitCodeProcess(subprocess, &exit_code))
+        char name[64];
+
+        psnprintf(name, sizeof(name), "/calico-cfg-%ld", (long) getpid());
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+        if (fd < 0)
         {
             return -1;
         }
 
-        if (exit_code != STILL_ACTIVE)
-        {
-            return exit_code;
-        }
+        shm_unlink(name);
     }
-}
 
-static void ConcatWCString(std::wstring &wstr, const char *value)
-{
-    const int clen = (int)(strlen(value));
-    const int size_needed = MultiByteToWideChar(CP_UTF8, 0, value, clen, nullptr, 0);
-    
-    std::unique_ptr<wchar_t []> upwstrTo { new wchar_t [ size_needed + 1 ] };
-    memset(upwstrTo.get(), 0, (size_needed+1) * sizeof(wchar_t));
-    MultiByteToWideChar(CP_UTF8, 0, value, clen, upwstrTo.get(), size_needed);
+    // Not all systems support write() on shared memory, so map it.
 
-    wstr += upwstrTo.get();
-}
+    if (ftruncate(fd, text.length()) != 0)
+    {
+        close(fd);
+        return -1;
+    }
 
-//
-// Build the command line string, a wide character string of the form:
-//
-// "program" "arg"...
-//
-static std::wstring BuildCommandLine(const char *program, execute_context_t *context)
-{
-    std::wstring result;
-    wchar_t exe_path[MAX_PATH];
+    mem = mmap(nullptr, text.length(), PROT_READ | PROT_WRITE, MAP_SHARED,
+               fd, 0);
 
-    // Get the path to this .exe file.
-    GetModuleFileNameW(nullptr, exe_path, MAX_PATH);
+    if (mem == MAP_FAILED)
+    {
+        close(fd);
+        return -1;
+    }
 
-    result.push_back(L'"');
+    memcpy(mem, text.constPtr(), text.length());
+    munmap(mem, text.length());
 
-    // Copy the path part of the filename (including ending \)
-    // into the result buffer:
-    wchar_t *sep = wcsrchr(exe_path, L'\\');
-    if(sep != nullptr)
+#if defined(F_ADD_SEALS)
+    if (sealable)
     {
-        result.append(exe_path, sep - exe_path + 1);
+        fcntl(fd, F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
     }
+#endif
+
+    return fd;
+}
 
-    // Concatenate the name of the program:
-    ConcatWCString(result, program);
+#endif
+
+// Save the configuration before launching the game.
 
-    // End of program name, start of arguments:
-    result += L"\"";
- 
-    for(const qstring &arg : context->args)
+void SaveConfigForLaunch(execute_context_t *context)
+{
+#if !defined(_WIN32)
+    if (UseConfigHandoff())
     {
-        result += L" ";
-        ConcatWCString(result, arg.constPtr());
+        context->cfg_fd = CreateConfigHandoff();
+
+        if (context->cfg_fd >= 0)
+        {
+            AddCmdLineParameter(context, "-cfgfd %i", context->cfg_fd);
+            Cfg_WriteFileAsync();
+            return;
+        }
     }
-    
-    return result;
+#endif
+
+    Cfg_WriteFile();
 }
 
-static int ExecuteCommand(const char *program, execute_context_t *context)
+// Stand-in for the game, for testing the configuration handoff: print
+// the configuration that was loaded and exit.
+
+void RunConfigStandIn(void)
 {
-    STARTUPINFOW startup_info;
-    PROCESS_INFORMATION proc_info;
-    std::wstring command;
-    int result = 0;
+    qstring text;
 
-    command = BuildCommandLine(program, context);
+    Cfg_WriteBuffer(text);
+    printf("%s: received %d bytes of configuration\n%s", myargv[0],
+           (int) text.length(), text.constPtr());
+    fflush(stdout);
+}
 
-    // Invoke the program:
+#if defined(_WIN32)
 
-    memset(&proc_info, 0, sizeof(proc_info));
-    memset(&startup_info, 0, sizeof(startup_info));
-    startup_info.cb = sizeof(startup_info);
+boolean OpenFolder(const char *path)
+{
+    // "If the function succeeds, it returns a value greater than 32."
+    return intptr_t(ShellExecute(nullptr, "open", path, nullptr, nullptr, SW_SHOWDEFAULT)) > 32;
+}
 
-    // make mutable copy
-    std::unique_ptr<wchar_t []> upCmdLine { new wchar_t [command.length() + 1] };
-    wcsncpy(upCmdLine.get(), command.c_str(), command.length() + 1);
+// Given the specified program name, get the full path to the program,
+// assuming that it is in the same directory as this program is.
+
+static char *GetFullExePath(const char *program)
+{
+    wchar_t exe_path[MAX_PATH];
+    char path[MAX_PATH * 4];
+
+    // Get the path to this .exe file.
+    GetModuleFileNameW(nullptr, exe_path, MAX_PATH);
 
-    if (!CreateProcessW(nullptr, upCmdLine.get(),
-                        nullptr, nullptr, FALSE, 0, nullptr, nullptr,
-                        &startup_info, &proc_info))
+    // Keep the path part of the filename (including ending \)
+    wchar_t *sep = wcsrchr(exe_path, L'\\');
+    if (sep == nullptr)
     {
-        result = -1;
+        return M_StringDuplicate(program);
     }
-    else
-    {
-        // Wait for the process to finish, and save the exit code.
+    sep[1] = L'\0';
 
-        result = WaitForProcessExit(proc_info.hProcess);
-
-        CloseHandle(proc_info.hProcess);
-        CloseHandle(proc_info.hThread);
+    if (!WideCharToMultiByte(CP_UTF8, 0, exe_path, -1, path, sizeof(path),
+                             nullptr, nullptr))
+    {
+        return M_StringDuplicate(program);
     }
 
-    return result;
+    return M_StringJoin(path, program, nullptr);
 }
 
 #else
@@ -283,102 +353,421 @@ static char *GetFullExePath(const char *program)
     return result;
 }
 
-static int ExecuteCommand(const char *program, execute_context_t *context)
-{
-    pid_t childpid;
-    int result;
-    
+#endif
+
+// Split a command line parameter into separate arguments. Parameters
+// are written as they would appear on a Windows command line, eg.
+// -iwad "C:\Program Files\doom.wad", and are passed through unchanged
+// there; elsewhere, they must be broken up and unquoted.
 
-    childpid = fork();
+static void SplitParameter(args_t &argv, const qstring &param)
+{
+#ifdef _WIN32
+    argv.push_back(param);
+#else
+    const char *p = param.constPtr();
 
-    if (childpid == 0) 
+    for (;;)
     {
-        // This is the child.  Execute the command.
+        qstring arg;
+        bool quoted = false;
 
-        const size_t numargs = 2 + context->args.size();
-        std::unique_ptr<const char *[]> upArgs { new const char * [numargs] };
+        while (isspace((unsigned char)*p))
+        {
+            ++p;
+        }
 
-        size_t idx = 0;
-        upArgs[idx++] = GetFullExePath(program);
-        for(const qstring &str : context->args)
-            upArgs[idx++] = str.constPtr();
-        upArgs[idx] = nullptr;
+        if (*p == '\0')
+        {
+            break;
+        }
 
-        execvp(upArgs[0], upArgs.get());
+        for (; *p != '\0' && (quoted || !isspace((unsigned char)*p)); ++p)
+        {
+            if (*p == '"')
+            {
+                quoted = !quoted;
+            }
+            else
+            {
+                arg += *p;
+            }
+        }
 
-        exit(0x80);
+        argv.push_back(std::move(arg));
     }
-    else
+#endif
+}
+
+struct execute_wait_t
+{
+    ExecuteCallback callback;
+    void *user_data;
+};
+
+static void ExecuteOutputCallback(txt_process_t *process, const char *data,
+                                  size_t len, void *user_data)
+{
+    for (size_t i = 0; i < len; ++i)
     {
-        // This is the parent.  Wait for the child to finish, and return
-        // the status code.
+        char c = data[i];
 
-        waitpid(childpid, &result, 0);
+        if (c == '\r')
+        {
+            continue;
+        }
+
+        if (c != '\n' && launch_log_column == LAUNCH_LOG_WIDTH)
+        {
+            launch_log += '\n';
+            launch_log_column = 0;
+        }
 
-        if (WIFEXITED(result) && WEXITSTATUS(result) != 0x80) 
+        if (c == '\n')
         {
-            return WEXITSTATUS(result);
+            launch_log_column = 0;
         }
         else
         {
-            return -1;
+            if (c == '\t' || (c >= 0 && c < ' '))
+            {
+                c = ' ';
+            }
+            ++launch_log_column;
         }
+
+        launch_log += c;
+    }
+
+    // Drop whole lines from the start to stay within the limit.
+
+    if (launch_log.length() > LAUNCH_LOG_SIZE)
+    {
+        size_t start = launch_log.length() - LAUNCH_LOG_SIZE;
+        size_t nl = launch_log.find("\n", start);
+
+        launch_log.erase(0, nl == qstring::npos ? start : nl + 1);
     }
 }
 
-#endif
+static void ExecuteExitCallback(txt_process_t *process, int exit_status,
+                                void *user_data)
+{
+    execute_wait_t *wait = static_cast<execute_wait_t *>(user_data);
 
-int ExecuteDoom(execute_context_t *context)
+    launch_running = false;
+    launch_exit_status = exit_status;
+
+    if (wait->callback != nullptr)
+    {
+        wait->callback(exit_status, wait->user_data);
+    }
+
+    delete wait;
+}
+
+int ExecuteDoom(execute_context_t *context, ExecuteCallback callback,
+                void *user_data)
 {
-    int result;
-    
-    // Run Doom
+    args_t args;
+    std::vector<const char *> argv;
+    txt_process_t *process;
+    execute_wait_t *wait;
+    int capture;
+    int cfg_fd;
+    char *program;
 
-    result = ExecuteCommand(GetExecutableName(), context);
+    // Build the argument list up front; nothing is left to do after
+    // the program has been started.
+
+    if (M_FindArgument("-cfgstandin"))
+    {
+        // The stand-in prints straight to our terminal.
+
+        program = M_StringDuplicate(myargv[0]);
+        AddCmdLineParameter(context, "-cfgprint");
+        capture = 0;
+    }
+    else
+    {
+        program = GetFullExePath(GetExecutableName());
+        capture = TXT_PROCESS_CAPTURE_STDOUT | TXT_PROCESS_CAPTURE_STDERR;
+    }
+
+    args.push_back(qstring(program));
+    free(program);
+
+    for (const qstring &param : context->args)
+    {
+        SplitParameter(args, param);
+    }
+
+    for (const qstring &arg : args)
+    {
+        argv.push_back(arg.constPtr());
+    }
+    argv.push_back(nullptr);
+
+    cfg_fd = context->cfg_fd;
 
     // Destroy context
     delete context;
 
-    return result;
+#if !defined(_WIN32)
+    // The handoff descriptor must survive into the game.
+
+    if (cfg_fd >= 0)
+    {
+        fcntl(cfg_fd, F_SETFD, 0);
+    }
+#endif
+
+    launch_log.clear();
+    launch_log_column = 0;
+
+    launch_have_cached =
+        Prefetch_Finish(&launch_cached, &launch_cached_total) != 0;
+
+    // Run Doom. We are told when it exits through the main loop; its
+    // output is kept for the log window.
+
+    wait = new execute_wait_t { callback, user_data };
+    process = TXT_SpawnProcess(argv.data(), capture, ExecuteOutputCallback,
+                               ExecuteExitCallback, wait);
+
+#if !defined(_WIN32)
+    if (cfg_fd >= 0)
+    {
+        close(cfg_fd);
+    }
+#endif
+
+    launch_started = (process != nullptr);
+    launch_running = launch_started;
+
+    if (process == nullptr)
+    {
+        delete wait;
+        return -1;
+    }
+
+    launch_spawn_time = TXT_GetProcessSpawnTime(process);
+
+    return 0;
 }
 
-static void TestCallback(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(data))
+// Show the output of the most recently launched game.
+
+void ShowLaunchLog(TXT_UNCAST_ARG(widget), void *user_data)
 {
-#if DEADCODE
-    execute_context_t *exec;
-    char *main_cfg;
-    char *extra_cfg;
-    txt_window_t *testwindow;
+    txt_window_t *window;
+    txt_scrollpane_t *pane;
+    qstring status;
+    qstring text;
 
-    testwindow = TXT_MessageBox("Starting Doom",
-                                "Starting Doom to test the\n"
-                                "settings.  Please wait.");
-    TXT_DrawDesktop();
+    if (!launch_started)
+    {
+        status = "The game could not be started.";
+    }
+    else
+    {
+        status.printf("Started in %.1f ms. ", launch_spawn_time / 1000.0);
 
-    // Save temporary configuration files with the current configuration
+        if (launch_have_cached)
+        {
+            qstring cached;
 
-    main_cfg = TempFile("tmp.cfg");
-    extra_cfg = TempFile("extratmp.cfg");
+            cached.printf("%.1f of %.1f MB of WADs cached. ",
+                          launch_cached / 1048576.0,
+                          launch_cached_total / 1048576.0);
+            status << cached;
+        }
 
-    //M_SaveDefaultsAlternate(main_cfg, extra_cfg);
+        if (launch_running)
+        {
+            status += "Still running.";
+        }
+        else if (launch_exit_status < 0)
+        {
+            status += "Killed.";
+        }
+        else
+        {
+            status << "Exit status " << launch_exit_status << ".";
+        }
+    }
 
-    // Run with the -testcontrols parameter
+    text = launch_log;
+    text.rstrip('\n');
 
-    exec = NewExecuteContext();
-    AddCmdLineParameter(exec, "-testcontrols");
-    AddCmdLineParameter(exec, "-config \"%s\"", main_cfg);
-    AddCmdLineParameter(exec, "-extraconfig \"%s\"", extra_cfg);
-    ExecuteDoom(exec);
+    if (text.empty())
+    {
+        text = "(No output)";
+    }
 
-    TXT_CloseWindow(testwindow);
+    window = TXT_NewWindow("Game output");
 
-    // Delete the temporary config files
+    TXT_AddWidgets(window,
+                   TXT_NewLabel(status.constPtr()),
+                   TXT_NewSeparator(nullptr),
+                   pane = TXT_NewScrollPane(70, 16,
+                                            TXT_NewLabel(text.constPtr())),
+                   nullptr);
 
-    remove(main_cfg);
-    remove(extra_cfg);
-    free(main_cfg);
-    free(extra_cfg);
+    // Start at the end, where any error messages will be.
+
+    pane->y = INT_MAX;
+
+    TXT_SetWindowAction(window, TXT_HORIZ_LEFT, nullptr);
+    TXT_SetWindowAction(window, TXT_HORIZ_CENTER,
+                        TXT_NewWindowEscapeAction(window));
+    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, nullptr);
+}
+
+//
+// Test action
+//
+// Runs the game with the settings being edited, without saving them, and
+// reports how it went. The settings are handed over in memory with
+// -cfghandoff where possible, otherwise through a temporary file.
+//
+
+struct test_launch_t
+{
+    txt_window_t *window;
+    char *cfg_file; // temporary file to remove afterwards, or nullptr
+    std::chrono::steady_clock::time_point start;
+};
+
+static void DeleteTestLaunch(test_launch_t *test)
+{
+    if (test->cfg_file != nullptr)
+    {
+        remove(test->cfg_file);
+        free(test->cfg_file);
+    }
+
+    delete test;
+}
+
+// Give the settings being tested to the game. Returns false on failure.
+
+static bool AddTestConfig(execute_context_t *context, test_launch_t *test)
+{
+    qstring text;
+    FILE *f;
+    bool ok;
+
+#if !defined(_WIN32)
+    if (UseConfigHandoff())
+    {
+        context->cfg_fd = CreateConfigHandoff();
+
+        if (context->cfg_fd >= 0)
+        {
+            AddCmdLineParameter(context, "-cfgfd %i", context->cfg_fd);
+            return true;
+        }
+    }
 #endif
+
+    Cfg_WriteBuffer(text);
+
+    test->cfg_file = TempFile("calico-test.cfg");
+    f = fopen(test->cfg_file, "w");
+
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    ok = fwrite(text.constPtr(), 1, text.length(), f) == text.length();
+
+    if (fclose(f) != 0 || !ok)
+    {
+        return false;
+    }
+
+    AddCmdLineParameter(context, "-config \"%s\"", test->cfg_file);
+    return true;
+}
+
+static void TestFinished(int result, void *user_data)
+{
+    test_launch_t *test = static_cast<test_launch_t *>(user_data);
+    txt_window_t *window;
+    txt_window_action_t *log_action;
+    qstring message;
+    double seconds;
+
+    seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - test->start).count();
+
+    TXT_CloseWindow(test->window);
+    DeleteTestLaunch(test);
+
+    if (result < 0)
+    {
+        message.printf("The game was killed after %.1f seconds.", seconds);
+    }
+    else
+    {
+        message.printf("The game exited with status %i\n"
+                       "after %.1f seconds (%.1f ms to start).",
+                       result, seconds, launch_spawn_time / 1000.0);
+    }
+
+    window = TXT_NewWindow("Test finished");
+    TXT_AddWidget(window, TXT_NewLabel(message.constPtr()));
+
+    log_action = TXT_NewWindowAction('l', "View log");
+    TXT_SignalConnect(log_action, "pressed", ShowLaunchLog, nullptr);
+
+    TXT_SetWindowAction(window, TXT_HORIZ_LEFT, nullptr);
+    TXT_SetWindowAction(window, TXT_HORIZ_CENTER,
+                        TXT_NewWindowEscapeAction(window));
+    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, log_action);
+}
+
+static int TestRunningKeyPress(txt_window_t *window, int key, void *user_data)
+{
+    // Nothing can be done until the game exits.
+    return 1;
+}
+
+static void TestCallback(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(data))
+{
+    execute_context_t *exec;
+    test_launch_t *test;
+
+    exec = NewExecuteContext();
+    test = new test_launch_t {};
+
+    if (!AddTestConfig(exec, test))
+    {
+        delete exec;
+        DeleteTestLaunch(test);
+        TXT_MessageBox("Execution error",
+                       "Could not save the settings to test.");
+        return;
+    }
+
+    PassThroughArguments(exec);
+
+    test->window = TXT_MessageBox("Testing settings",
+                                  "The game is running with\n"
+                                  "the settings being tested.");
+    TXT_SetWindowAction(test->window, TXT_HORIZ_CENTER, nullptr);
+    TXT_SetKeyListener(test->window, TestRunningKeyPress, nullptr);
+
+    test->start = std::chrono::steady_clock::now();
+
+    if (ExecuteDoom(exec, TestFinished, test) < 0)
+    {
+        TXT_CloseWindow(test->window);
+        DeleteTestLaunch(test);
+        TXT_MessageBox("Execution error", "Could not start the game.");
+    }
 }
 
 txt_window_action_t *TestConfigAction(void)
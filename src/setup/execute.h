@@ -18,6 +18,11 @@
 
 typedef struct execute_context_s execute_context_t;
 
+// Callback invoked from the main loop when a game started by ExecuteDoom
+// exits. The result is the game's exit status, or -1 if it was killed.
+
+typedef void (*ExecuteCallback)(int result, void *user_data);
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -26,7 +31,11 @@ execute_context_t *NewExecuteContext(void);
 
 void    AddCmdLineParameter(execute_context_t *context, const char *s, ...) PRINTF_ATTR(2, 3);
 void    PassThroughArguments(execute_context_t *context);
-int     ExecuteDoom(execute_context_t *context);
+void    SaveConfigForLaunch(execute_context_t *context);
+void    RunConfigStandIn(void);
+int     ExecuteDoom(execute_context_t *context, ExecuteCallback callback,
+                    void *user_data);
+void    ShowLaunchLog(TXT_UNCAST_ARG(widget), void *user_data);
 int     FindInstalledIWADs(void);
 boolean OpenFolder(const char *path);
 
@@ -0,0 +1,714 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+// Code for finding IWADs and Jaguar ROMs.
+//
+// The directories in iwad_search_path are walked by a pool of worker
+// threads. Each candidate file is validated and identified by its WAD
+// header and directory, and by a CRC-32 of its contents, computed in
+// chunks in parallel. The results are kept in an index file, keyed by
+// path, size and modification time, so that a rescan only has to read
+// files that are new or have changed.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "../elib/elib.h"
+#include "../elib/atexit.h"
+#include "../elib/configfile.h"
+#include "../elib/crc32.h"
+#include "../elib/log.h"
+#include "../elib/qstring.h"
+#include "../elib/wadfile.h"
+#include "../hal/hal_ml.h"
+#include "../hal/hal_platform.h"
+#include "iwadscan.h"
+
+#define SCAN_CHUNK_SIZE  (1024 * 1024)
+#define SCAN_MAX_DEPTH   4
+#define SCAN_MAX_THREADS 8
+
+// Directories to search, separated by semicolons. If not set, the
+// current directory and the configuration directory are searched.
+
+static char *iwad_search_path;
+
+static CfgItem cfgIwadSearchPath("iwad_search_path", &iwad_search_path);
+
+struct indexentry_t
+{
+    long long    size;
+    long long    mtime;
+    unsigned int crc;
+    iwadkind_t   kind;
+};
+
+using index_t = std::map<qstring, indexentry_t>;
+
+// Index from the previous scan; read-only while scanning.
+
+static index_t old_index;
+
+// Work queue shared by the scanner threads. Everything below is
+// protected by scan_lock.
+
+static std::mutex                        scan_lock;
+static std::condition_variable           scan_cond;
+static std::deque<std::function<void()>> scan_tasks;
+static std::vector<std::thread>          scan_threads;
+static int                               scan_pending; // queued or running
+static bool                              scan_cancelled;
+static index_t                           new_index;
+
+// List for the IWAD dropdown. Lists are never freed, so that callers
+// may keep pointers into them.
+
+static std::mutex               list_lock;
+static const iwadinfo_t *const *iwad_list;
+
+//
+// Index file
+//
+
+static qstring IndexFileName(void)
+{
+    qstring name(hal_medialayer.getWriteDirectory(ELIB_APPNAME));
+    name.pathConcatenate("iwads.idx");
+    return name;
+}
+
+// Index lines are of the form:
+//
+// <size> <mtime> <crc> <kind> <path>
+
+static void LoadIndex(void)
+{
+    qstring name = IndexFileName();
+    char line[1024];
+    FILE *f;
+
+    f = hal_platform.fileOpen(name.constPtr(), "r");
+
+    if (f == nullptr)
+    {
+        return;
+    }
+
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        indexentry_t entry;
+        int kind, pos = 0;
+        qstring path;
+
+        if (sscanf(line, "%lld %lld %x %d %n", &entry.size, &entry.mtime,
+                   &entry.crc, &kind, &pos) < 4 || pos == 0)
+        {
+            continue;
+        }
+
+        path = line + pos;
+        path.rstrip('\n');
+        path.rstrip('\r');
+
+        if (path.empty() || kind < IWADSCAN_IWAD || kind > IWADSCAN_ROM)
+        {
+            continue;
+        }
+
+        entry.kind = static_cast<iwadkind_t>(kind);
+        old_index[path] = entry;
+    }
+
+    fclose(f);
+}
+
+static void WriteIndex(const index_t &index)
+{
+    qstring name = IndexFileName();
+    qstring tmpName = name;
+    FILE *f;
+    bool ok = true;
+
+    tmpName += ".tmp";
+
+    f = hal_platform.fileOpen(tmpName.constPtr(), "w");
+
+    if (f == nullptr)
+    {
+        hal_platform.debugMsg("Warning: could not write %s\n",
+                              tmpName.constPtr());
+        return;
+    }
+
+    for (const auto &it : index)
+    {
+        const indexentry_t &entry = it.second;
+
+        if (fprintf(f, "%lld %lld %08x %d %s\n", entry.size, entry.mtime,
+                    entry.crc, entry.kind, it.first.constPtr()) < 0)
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    if (fclose(f) != 0 || !ok)
+    {
+        remove(tmpName.constPtr());
+        return;
+    }
+
+    remove(name.constPtr());
+    rename(tmpName.constPtr(), name.constPtr());
+}
+
+//
+// IWAD list
+//
+
+static const char *KindName(iwadkind_t kind)
+{
+    switch (kind)
+    {
+        case IWADSCAN_IWAD:
+            return "WAD";
+        case IWADSCAN_PWAD:
+            return "PWAD";
+        default:
+            return "ROM";
+    }
+}
+
+// Build and publish the list for the IWAD dropdown from an index.
+
+static void PublishList(const index_t &index)
+{
+    std::vector<const iwadinfo_t *> list;
+
+    for (const auto &it : index)
+    {
+        const indexentry_t &entry = it.second;
+        iwadinfo_t *info;
+        qstring path = it.first;
+        qstring base;
+        qstring description;
+
+        // PWADs can't be played on their own.
+
+        if (entry.kind == IWADSCAN_PWAD)
+        {
+            continue;
+        }
+
+        path.extractFileBase(base);
+        description.printf("%s (%s, %08X)", base.constPtr(),
+                           KindName(entry.kind), entry.crc);
+
+        info = new iwadinfo_t;
+        info->path = path.duplicate();
+        info->description = description.duplicate();
+        info->kind = entry.kind;
+        info->crc = entry.crc;
+        list.push_back(info);
+    }
+
+    list.push_back(nullptr);
+
+    const iwadinfo_t **published = new const iwadinfo_t *[list.size()];
+    std::copy(list.begin(), list.end(), published);
+
+    std::lock_guard<std::mutex> guard(list_lock);
+    iwad_list = published;
+}
+
+//
+// Work queue
+//
+
+static void QueueTask(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> guard(scan_lock);
+
+    if (!scan_cancelled)
+    {
+        ++scan_pending;
+        scan_tasks.push_back(std::move(task));
+        scan_cond.notify_one();
+    }
+}
+
+static void AddResult(const qstring &path, const indexentry_t &entry)
+{
+    std::lock_guard<std::mutex> guard(scan_lock);
+    new_index[path] = entry;
+}
+
+// Called by whichever thread completes the last task.
+
+static void FinishScan(void)
+{
+    E_LOG(LOGLEVEL_INFO, "iwadscan", "Scan finished with %d files indexed",
+          static_cast<int>(new_index.size()));
+
+    WriteIndex(new_index);
+    PublishList(new_index);
+}
+
+static void WorkerThread(void)
+{
+    std::unique_lock<std::mutex> lock(scan_lock);
+
+    for (;;)
+    {
+        scan_cond.wait(lock, [] {
+            return !scan_tasks.empty() || scan_pending == 0 || scan_cancelled;
+        });
+
+        if (scan_tasks.empty() || scan_cancelled)
+        {
+            return;
+        }
+
+        std::function<void()> task = std::move(scan_tasks.front());
+        scan_tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        if (--scan_pending == 0)
+        {
+            // Nothing more can be queued now, so the index is ours.
+
+            scan_cond.notify_all();
+
+            if (!scan_cancelled)
+            {
+                lock.unlock();
+                FinishScan();
+                lock.lock();
+            }
+        }
+    }
+}
+
+// Stop the scan at exit. Files that were not finished are simply left
+// out of the index.
+
+static void StopScan(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(scan_lock);
+        scan_cancelled = true;
+        scan_pending -= static_cast<int>(scan_tasks.size());
+        scan_tasks.clear();
+        scan_cond.notify_all();
+    }
+
+    for (std::thread &thread : scan_threads)
+    {
+        thread.join();
+    }
+
+    scan_threads.clear();
+}
+
+//
+// Scanning
+//
+
+struct scanfile_t
+{
+    qstring               path;
+    indexentry_t          entry;
+    std::vector<uint32_t> chunk_crcs;
+    std::atomic<int>      remaining;
+    std::atomic<bool>     failed;
+};
+
+static bool IsCandidate(const char *name)
+{
+    static const char *const extensions[] = { ".wad", ".jag", ".j64", ".rom" };
+    size_t len = strlen(name);
+
+    for (const char *ext : extensions)
+    {
+        size_t extlen = strlen(ext);
+
+        if (len > extlen && !strcasecmp(name + len - extlen, ext))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Identify a file from its header and lump directory. Returns false if
+// it is not of interest, or is not a valid WAD.
+
+static bool Identify(const char *path, iwadkind_t &kind)
+{
+    waderror_t error;
+    wadfile_t *wad = Wad_Open(path, &error);
+
+    if (wad == nullptr)
+    {
+        E_LOG(LOGLEVEL_DEBUG, "iwadscan", "Skipping %s: %s", path,
+              Wad_ErrorString(error));
+        return false;
+    }
+
+    if (Wad_Flags(wad) & WAD_INROM)
+    {
+        kind = IWADSCAN_ROM;
+    }
+    else if (Wad_Type(wad) == WAD_IWAD)
+    {
+        kind = IWADSCAN_IWAD;
+    }
+    else
+    {
+        kind = IWADSCAN_PWAD;
+    }
+
+    Wad_Close(wad);
+
+    return true;
+}
+
+// Seek with a 64-bit offset, as long is only 32 bits on Windows.
+
+static int SeekFile(FILE *f, long long offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(f, offset, SEEK_SET);
+#else
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+static void HashChunk(std::shared_ptr<scanfile_t> file, size_t chunk)
+{
+    std::unique_ptr<uint8_t []> buffer { new uint8_t [SCAN_CHUNK_SIZE] };
+    long long offset = static_cast<long long>(chunk) * SCAN_CHUNK_SIZE;
+    size_t want, len;
+    FILE *f;
+
+    want = static_cast<size_t>(file->entry.size - offset);
+
+    if (want > SCAN_CHUNK_SIZE)
+    {
+        want = SCAN_CHUNK_SIZE;
+    }
+
+    f = hal_platform.fileOpen(file->path.constPtr(), "rb");
+
+    if (f == nullptr || SeekFile(f, offset) != 0)
+    {
+        file->failed = true;
+        len = 0;
+    }
+    else
+    {
+        len = fread(buffer.get(), 1, want, f);
+
+        if (len != want)
+        {
+            file->failed = true;
+        }
+    }
+
+    if (f != nullptr)
+    {
+        fclose(f);
+    }
+
+    file->chunk_crcs[chunk] = E_CRC32(0, buffer.get(), len);
+
+    // The last chunk to finish puts the CRC together.
+
+    if (--file->remaining == 0 && !file->failed)
+    {
+        uint32_t crc = file->chunk_crcs[0];
+        long long left = file->entry.size - SCAN_CHUNK_SIZE;
+
+        for (size_t i = 1; i < file->chunk_crcs.size(); ++i)
+        {
+            long long chunk_len = left > SCAN_CHUNK_SIZE ? SCAN_CHUNK_SIZE
+                                                         : left;
+
+            crc = E_CRC32Combine(crc, file->chunk_crcs[i], chunk_len);
+            left -= chunk_len;
+        }
+
+        file->entry.crc = crc;
+        AddResult(file->path, file->entry);
+    }
+}
+
+static void ScanFile(qstring path, long long size, long long mtime)
+{
+    auto file = std::make_shared<scanfile_t>();
+    size_t num_chunks;
+
+    if (!Identify(path.constPtr(), file->entry.kind))
+    {
+        return;
+    }
+
+    num_chunks = size > 0 ? (size + SCAN_CHUNK_SIZE - 1) / SCAN_CHUNK_SIZE
+                          : 1;
+
+    file->path = path;
+    file->entry.size = size;
+    file->entry.mtime = mtime;
+    file->entry.crc = 0;
+    file->chunk_crcs.resize(num_chunks);
+    file->remaining = static_cast<int>(num_chunks);
+    file->failed = false;
+
+    for (size_t i = 0; i < num_chunks; ++i)
+    {
+        QueueTask([file, i] { HashChunk(file, i); });
+    }
+}
+
+// Look at a candidate file: if it is unchanged since the last scan,
+// the indexed result is reused; otherwise it must be read.
+
+static void CheckFile(const qstring &path, long long size, long long mtime)
+{
+    auto it = old_index.find(path);
+
+    if (it != old_index.end()
+     && it->second.size == size && it->second.mtime == mtime)
+    {
+        AddResult(path, it->second);
+        return;
+    }
+
+    QueueTask([path, size, mtime] { ScanFile(path, size, mtime); });
+}
+
+static void ScanDirectory(qstring dir, int depth)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE handle;
+    qstring pattern = dir;
+
+    pattern.pathConcatenate("*");
+    handle = FindFirstFileA(pattern.constPtr(), &data);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        const char *name = data.cFileName;
+        qstring path;
+
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+        {
+            continue;
+        }
+
+        path = dir;
+        path.pathConcatenate(name);
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            if (depth < SCAN_MAX_DEPTH)
+            {
+                QueueTask([path, depth] { ScanDirectory(path, depth + 1); });
+            }
+        }
+        else if (IsCandidate(name))
+        {
+            long long size = (static_cast<long long>(data.nFileSizeHigh) << 32)
+                           | data.nFileSizeLow;
+            long long mtime =
+                (static_cast<long long>(data.ftLastWriteTime.dwHighDateTime) << 32)
+              | data.ftLastWriteTime.dwLowDateTime;
+
+            CheckFile(path, size, mtime);
+        }
+    } while (FindNextFileA(handle, &data));
+
+    FindClose(handle);
+#else
+    DIR *d = opendir(dir.constPtr());
+    struct dirent *ent;
+
+    if (d == nullptr)
+    {
+        return;
+    }
+
+    while ((ent = readdir(d)) != nullptr)
+    {
+        const char *name = ent->d_name;
+        struct stat st;
+        qstring path;
+
+        if (name[0] == '.')
+        {
+            continue; // skip hidden files, "." and ".."
+        }
+
+#ifdef DT_DIR
+        if (ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN
+         && ent->d_type != DT_LNK && !IsCandidate(name))
+        {
+            continue; // don't stat files we're not interested in
+        }
+#endif
+
+        path = dir;
+        path.pathConcatenate(name);
+
+        if (stat(path.constPtr(), &st) != 0)
+        {
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode))
+        {
+            if (depth < SCAN_MAX_DEPTH)
+            {
+                QueueTask([path, depth] { ScanDirectory(path, depth + 1); });
+            }
+        }
+        else if (S_ISREG(st.st_mode) && IsCandidate(name))
+        {
+            CheckFile(path, st.st_size, st.st_mtime);
+        }
+    }
+
+    closedir(d);
+#endif
+}
+
+// Split the search path into directories.
+
+static std::vector<qstring> SearchDirectories(void)
+{
+    std::vector<qstring> dirs;
+
+    if (estrempty(iwad_search_path))
+    {
+        dirs.push_back(qstring("."));
+        dirs.push_back(qstring(hal_medialayer.getWriteDirectory(ELIB_APPNAME)));
+        return dirs;
+    }
+
+    qstring dir;
+
+    for (const char *p = iwad_search_path; ; ++p)
+    {
+        if (*p == ';' || *p == '\0')
+        {
+            if (!dir.empty())
+            {
+                dirs.push_back(dir);
+            }
+            dir.clear();
+
+            if (*p == '\0')
+            {
+                break;
+            }
+        }
+        else
+        {
+            dir += *p;
+        }
+    }
+
+    return dirs;
+}
+
+//
+// External interface
+//
+
+// Show what was found last time straight away, and start a scan in the
+// background to bring it up to date.
+
+void IWADScan_Start(void)
+{
+    unsigned int num_threads;
+
+    if (!scan_threads.empty())
+    {
+        return;
+    }
+
+    LoadIndex();
+    PublishList(old_index);
+
+    for (const qstring &dir : SearchDirectories())
+    {
+        QueueTask([dir] { ScanDirectory(dir, 0); });
+    }
+
+    if (scan_pending == 0)
+    {
+        return;
+    }
+
+    num_threads = std::thread::hardware_concurrency();
+    num_threads = eclamp(num_threads, 2u, (unsigned int)SCAN_MAX_THREADS);
+
+    for (unsigned int i = 0; i < num_threads; ++i)
+    {
+        scan_threads.emplace_back(WorkerThread);
+    }
+
+    E_AtExit(StopScan, true);
+}
+
+// Get the IWADs and ROMs found: those in the index until the scan has
+// finished, then the results of the scan. The list is NULL-terminated,
+// and stays valid for the rest of the program.
+
+const iwadinfo_t *const *IWADScan_GetIWADs(void)
+{
+    static const iwadinfo_t *const empty_list[] = { nullptr };
+    std::lock_guard<std::mutex> guard(list_lock);
+
+    return iwad_list != nullptr ? iwad_list : empty_list;
+}
+
@@ -0,0 +1,43 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+#pragma once
+
+typedef enum
+{
+    IWADSCAN_IWAD,
+    IWADSCAN_PWAD,
+    IWADSCAN_ROM,
+} iwadkind_t;
+
+typedef struct iwadinfo_s
+{
+    const char  *path;        // path to pass to -iwad
+    const char  *description; // label to show in the IWAD list
+    iwadkind_t   kind;
+    unsigned int crc;         // CRC-32 of the whole file
+} iwadinfo_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void IWADScan_Start(void);
+
+const iwadinfo_t *const *IWADScan_GetIWADs(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
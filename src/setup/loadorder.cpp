@@ -0,0 +1,540 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+
+// PWAD load order analysis.
+//
+// The lump directories of the IWAD and the selected PWADs are indexed
+// by lump name, so that it can be seen which lumps each PWAD replaces,
+// and which of its own are in turn replaced by PWADs loaded after it.
+// Directories are read from the mapped files in parallel and cached
+// while the files are unchanged, and the index is only updated from
+// the first WAD in the load order that has changed, so adding or
+// removing the last WAD only costs the lumps in that WAD.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "../elib/elib.h"
+#include "../elib/qstring.h"
+#include "../elib/wadfile.h"
+#include "textscreen.h"
+#include "loadorder.h"
+
+#define REPORT_WIDTH 66
+
+// Lump names are packed into an integer, upper-cased, for hashing.
+
+typedef uint64_t lumpname_t;
+
+struct dirlump_t
+{
+    lumpname_t name;
+    uint32_t   size;     // total size of the lumps, for a map
+    size_t     index;    // lump number within the WAD
+    bool       is_map;
+};
+
+struct waddir_t
+{
+    qstring                path;
+    long long              size;
+    long long              mtime;
+    wadfile_t             *wad;
+    waderror_t             error;
+    std::vector<dirlump_t> lumps;  // the last lump of each name, by name
+
+    ~waddir_t()
+    {
+        Wad_Close(wad);
+    }
+};
+
+using waddir_ptr = std::shared_ptr<waddir_t>;
+
+// Directories that have been read, by path.
+
+static std::map<qstring, waddir_ptr> dir_cache;
+
+// The load order of the last analysis, and for each lump name, the
+// positions in it of the WADs that contain the lump, in order.
+
+static std::vector<waddir_ptr> load_order;
+static std::unordered_map<lumpname_t, std::vector<size_t>> lump_index;
+
+static lumpname_t PackName(const char *name)
+{
+    lumpname_t result = 0;
+
+    for (int i = 0; i < 8 && name[i] != '\0'; ++i)
+    {
+        result |= static_cast<lumpname_t>(ectype::toUpper(static_cast<unsigned char>(name[i]))) << (i * 8);
+    }
+
+    return result;
+}
+
+static qstring UnpackName(lumpname_t name)
+{
+    qstring result;
+
+    for (; name != 0; name >>= 8)
+    {
+        result << static_cast<char>(name & 0xff);
+    }
+
+    return result;
+}
+
+// Lumps that make up a map, following its marker lump.
+
+static bool IsMapLump(lumpname_t name)
+{
+    static const lumpname_t map_lumps[] =
+    {
+        PackName("THINGS"),   PackName("LINEDEFS"), PackName("SIDEDEFS"),
+        PackName("VERTEXES"), PackName("SEGS"),     PackName("SSECTORS"),
+        PackName("NODES"),    PackName("SECTORS"),  PackName("REJECT"),
+        PackName("BLOCKMAP"), PackName("BEHAVIOR"),
+    };
+
+    return std::find(std::begin(map_lumps), std::end(map_lumps), name)
+        != std::end(map_lumps);
+}
+
+static bool CompareLumps(const dirlump_t &lump1, const dirlump_t &lump2)
+{
+    return lump1.name < lump2.name;
+}
+
+// Read the directory of a WAD. Maps are treated as a single lump named
+// after their marker, and other empty lumps, which are only markers,
+// are left out.
+
+static void ReadDirectory(waddir_t *dir)
+{
+    static const lumpname_t things = PackName("THINGS");
+    std::unordered_map<lumpname_t, size_t> seen;
+    ptrdiff_t current_map = -1;
+    size_t num_lumps;
+    wadlump_t lump;
+
+    dir->wad = Wad_Open(dir->path.constPtr(), &dir->error);
+
+    if (dir->wad == nullptr)
+    {
+        return;
+    }
+
+    num_lumps = Wad_NumLumps(dir->wad);
+
+    for (size_t i = 0; i < num_lumps; ++i)
+    {
+        dirlump_t entry;
+
+        Wad_GetLump(dir->wad, i, &lump);
+
+        entry.name = PackName(lump.name);
+        entry.size = lump.size;
+        entry.index = i;
+        entry.is_map = false;
+
+        if (IsMapLump(entry.name))
+        {
+            if (current_map >= 0)
+            {
+                dir->lumps[current_map].size += lump.size;
+            }
+
+            continue;
+        }
+
+        current_map = -1;
+
+        if (i + 1 < num_lumps)
+        {
+            Wad_GetLump(dir->wad, i + 1, &lump);
+            entry.is_map = PackName(lump.name) == things;
+        }
+
+        if (entry.size == 0 && !entry.is_map)
+        {
+            continue;
+        }
+
+        auto it = seen.find(entry.name);
+
+        if (it != seen.end())
+        {
+            dir->lumps[it->second] = entry;
+        }
+        else
+        {
+            it = seen.emplace(entry.name, dir->lumps.size()).first;
+            dir->lumps.push_back(entry);
+        }
+
+        if (entry.is_map)
+        {
+            current_map = it->second;
+        }
+    }
+
+    std::sort(dir->lumps.begin(), dir->lumps.end(), CompareLumps);
+}
+
+// Get the directories of the given WADs, reading those that are not
+// cached, or have changed since, in parallel.
+
+static std::vector<waddir_ptr> GetDirectories(const std::vector<qstring> &paths,
+                                              int &num_read)
+{
+    std::vector<waddir_ptr> result;
+    std::vector<waddir_t *> to_read;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> next { 0 };
+    unsigned int num_threads;
+
+    for (const qstring &path : paths)
+    {
+        struct stat st;
+        long long size = -1, mtime = -1;
+
+        if (stat(path.constPtr(), &st) == 0)
+        {
+            size = st.st_size;
+            mtime = st.st_mtime;
+        }
+
+        waddir_ptr &cached = dir_cache[path];
+
+        if (cached == nullptr || cached->size != size
+         || cached->mtime != mtime)
+        {
+            cached = std::make_shared<waddir_t>();
+            cached->path = path;
+            cached->size = size;
+            cached->mtime = mtime;
+            cached->wad = nullptr;
+            cached->error = WAD_OK;
+            to_read.push_back(cached.get());
+        }
+
+        result.push_back(cached);
+    }
+
+    num_read = static_cast<int>(to_read.size());
+    num_threads = std::min<unsigned int>(std::thread::hardware_concurrency(),
+                                         num_read);
+
+    for (unsigned int i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&] {
+            size_t n;
+
+            while ((n = next++) < to_read.size())
+            {
+                ReadDirectory(to_read[n]);
+            }
+        });
+    }
+
+    // hardware_concurrency() may not be known
+    if (num_threads == 0)
+    {
+        for (waddir_t *dir : to_read)
+        {
+            ReadDirectory(dir);
+        }
+    }
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    return result;
+}
+
+// Bring the lump index up to date with a new load order. Everything
+// from the first WAD that differs onwards is removed from the index and
+// added again; the WADs before it are unaffected.
+
+static void UpdateIndex(const std::vector<waddir_ptr> &order)
+{
+    size_t first = 0;
+
+    while (first < load_order.size() && first < order.size()
+        && load_order[first] == order[first])
+    {
+        ++first;
+    }
+
+    // Each lump name is only listed once per WAD, and the positions are
+    // in order, so removing the last WADs first only pops from the end.
+
+    for (size_t i = load_order.size(); i-- > first; )
+    {
+        for (const dirlump_t &lump : load_order[i]->lumps)
+        {
+            auto it = lump_index.find(lump.name);
+
+            it->second.pop_back();
+
+            if (it->second.empty())
+            {
+                lump_index.erase(it);
+            }
+        }
+    }
+
+    for (size_t i = first; i < order.size(); ++i)
+    {
+        for (const dirlump_t &lump : order[i]->lumps)
+        {
+            lump_index[lump.name].push_back(i);
+        }
+    }
+
+    load_order = order;
+}
+
+static const dirlump_t *FindLump(const waddir_t *dir, lumpname_t name)
+{
+    dirlump_t key;
+
+    key.name = name;
+
+    return &*std::lower_bound(dir->lumps.begin(), dir->lumps.end(), key,
+                              CompareLumps);
+}
+
+// Check whether two versions of a lump differ. Maps and compressed
+// lumps are only compared by size.
+
+static bool LumpsDiffer(const waddir_t *dir1, const dirlump_t *lump1,
+                        const waddir_t *dir2, const dirlump_t *lump2)
+{
+    wadlump_t info1, info2;
+
+    if (lump1->size != lump2->size)
+    {
+        return true;
+    }
+
+    if (lump1->is_map || lump2->is_map)
+    {
+        return false;
+    }
+
+    Wad_GetLump(dir1->wad, lump1->index, &info1);
+    Wad_GetLump(dir2->wad, lump2->index, &info2);
+
+    if (info1.compressed || info2.compressed)
+    {
+        return false;
+    }
+
+    return memcmp(Wad_LumpData(dir1->wad, lump1->index),
+                  Wad_LumpData(dir2->wad, lump2->index), lump1->size) != 0;
+}
+
+static const char *FileName(const qstring &path)
+{
+    const char *p = path.constPtr();
+    const char *name = p;
+
+    for (; *p != '\0'; ++p)
+    {
+        if (*p == '/' || *p == '\\')
+        {
+            name = p + 1;
+        }
+    }
+
+    return name;
+}
+
+// Add a list of lump names to the report, wrapped to fit.
+
+static void AddList(qstring &text, const char *heading,
+                    const std::vector<qstring> &items)
+{
+    size_t column = 0;
+
+    if (items.empty())
+    {
+        return;
+    }
+
+    text << "   " << heading << " (" << static_cast<int>(items.size())
+         << "):\n";
+
+    for (const qstring &item : items)
+    {
+        if (column > 0 && column + 1 + item.length() > REPORT_WIDTH)
+        {
+            text << '\n';
+            column = 0;
+        }
+
+        if (column == 0)
+        {
+            text << "      ";
+            column = 6;
+        }
+        else
+        {
+            text << ' ';
+            ++column;
+        }
+
+        text << item;
+        column += item.length();
+    }
+
+    text << '\n';
+}
+
+// Describe what one PWAD replaces, and what replaces it.
+
+static void ReportWAD(qstring &text, size_t position)
+{
+    const waddir_t *dir = load_order[position].get();
+    std::vector<qstring> replaces, shadowed, conflicts;
+
+    for (const dirlump_t &lump : dir->lumps)
+    {
+        const std::vector<size_t> &owners = lump_index[lump.name];
+        auto it = std::lower_bound(owners.begin(), owners.end(), position);
+        qstring name = UnpackName(lump.name);
+
+        if (it != owners.begin())
+        {
+            replaces.push_back(name);
+        }
+
+        if (it + 1 != owners.end())
+        {
+            const waddir_t *winner = load_order[owners.back()].get();
+
+            shadowed.push_back(name);
+
+            if (LumpsDiffer(dir, &lump, winner,
+                            FindLump(winner, lump.name)))
+            {
+                conflicts.push_back(name << " (" << FileName(winner->path)
+                                          << ")");
+            }
+        }
+    }
+
+    std::sort(replaces.begin(), replaces.end());
+    std::sort(shadowed.begin(), shadowed.end());
+    std::sort(conflicts.begin(), conflicts.end());
+
+    AddList(text, "Replaces", replaces);
+    AddList(text, "Replaced by later WADs", shadowed);
+    AddList(text, "Conflicts with later WADs", conflicts);
+}
+
+static void BuildReport(qstring &text, size_t first_pwad)
+{
+    for (size_t i = 0; i < load_order.size(); ++i)
+    {
+        const waddir_t *dir = load_order[i].get();
+        qstring line;
+
+        line.printf("%i. %s: ", static_cast<int>(i + 1),
+                    FileName(dir->path));
+
+        if (dir->wad == nullptr)
+        {
+            text << line << Wad_ErrorString(dir->error) << "\n";
+            continue;
+        }
+
+        text << line << (i < first_pwad ? "IWAD, " : "PWAD, ")
+             << static_cast<int>(dir->lumps.size()) << " lumps\n";
+
+        if (i >= first_pwad)
+        {
+            ReportWAD(text, i);
+        }
+    }
+}
+
+void ShowLoadOrderReport(const char *iwad, char **pwads, int num_pwads)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<qstring> paths;
+    size_t first_pwad = 0;
+    txt_window_t *window;
+    qstring status;
+    qstring text;
+    int num_read;
+
+    if (iwad != nullptr)
+    {
+        paths.push_back(qstring(iwad));
+        first_pwad = 1;
+    }
+
+    for (int i = 0; i < num_pwads; ++i)
+    {
+        if (pwads[i] != nullptr && strlen(pwads[i]) > 0)
+        {
+            paths.push_back(qstring(pwads[i]));
+        }
+    }
+
+    UpdateIndex(GetDirectories(paths, num_read));
+    BuildReport(text, first_pwad);
+    text.rstrip('\n');
+
+    if (load_order.size() <= first_pwad)
+    {
+        text << "\n\nNo PWADs have been added.";
+    }
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    status.printf("%i unique lumps. Analyzed in %.1f ms, %i read.",
+                  static_cast<int>(lump_index.size()), elapsed.count(),
+                  num_read);
+
+    window = TXT_NewWindow("Load order");
+
+    TXT_AddWidgets(window,
+                   TXT_NewLabel(status.constPtr()),
+                   TXT_NewSeparator(nullptr),
+                   TXT_NewScrollPane(70, 16, TXT_NewLabel(text.constPtr())),
+                   nullptr);
+
+    TXT_SetWindowAction(window, TXT_HORIZ_LEFT, nullptr);
+    TXT_SetWindowAction(window, TXT_HORIZ_CENTER,
+                        TXT_NewWindowEscapeAction(window));
+    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, nullptr);
+}
+
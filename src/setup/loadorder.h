@@ -0,0 +1,30 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+
+#pragma once
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Analyze the load order of an IWAD and a list of PWADs, and show which
+// lumps each PWAD replaces. Empty entries in the list are skipped.
+
+void ShowLoadOrderReport(const char *iwad, char **pwads, int num_pwads);
+
+#if defined(__cplusplus)
+}
+#endif
+
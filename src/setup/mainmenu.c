@@ -14,6 +14,9 @@
 
 #include "../elib/elib.h"
 #include "../elib/configfile.h"
+#include "../elib/m_argv.h"
+#include "../elib/log.h"
+#include "../elib/trace.h"
 #include "../hal/hal_init.h"
 #include "../hal/hal_ml.h"
 #include "../sdl/sdl_hal.h"
@@ -22,6 +25,7 @@
 #include "doomkeys.h"
 #include "textscreen.h"
 #include "execute.h"
+#include "iwadscan.h"
 #include "setup_icon.c"
 #include "mode.h"
 #include "compatibility.h"
@@ -31,6 +35,7 @@
 #include "mouse.h"
 #include "multiplayer.h"
 #include "sound.h"
+#include "uibench.h"
 
 #define WINDOW_HELP_URL "https://www.chocolate-doom.org/setup"
 
@@ -208,23 +213,14 @@ static void LaunchDoom(void *unused1, void *unused2)
     
     // Save configuration first
 
-    Cfg_WriteFile();
+    SaveConfigForLaunch(exec);
     WriteEEProm();
 
     // Launch Doom
 
     exec = NewExecuteContext();
     PassThroughArguments(exec);
-    if(ExecuteDoom(exec) >= 0)
-    {
-        // Shut down textscreen GUI
-        TXT_Shutdown();
-        hal_medialayer.exit();
-    }
-    else
-    {
-        ShowLaunchError();
-    }
+    LaunchGame(exec);
 }
 
 static txt_button_t *GetLaunchButton(void)
@@ -382,6 +378,11 @@ static void SetIcon(void)
     extern SDL_Window *TXT_SDLWindow;
     SDL_Surface *surface;
 
+    if (TXT_SDLWindow == NULL)
+    {
+        return;
+    }
+
     surface = SDL_CreateRGBSurfaceFrom((void *) setup_icon_data, setup_icon_w,
                                        setup_icon_h, 32, setup_icon_w * 4,
                                        0xff << 24, 0xff << 16,
@@ -396,6 +397,58 @@ static void SetWindowTitle(void)
     TXT_SetDesktopTitle("Calico Configurator");
 }
 
+// Time taken by each phase of startup, printed with -startuptime.
+
+typedef struct
+{
+    const char *name;
+    Uint64 ticks;
+} startup_phase_t;
+
+static startup_phase_t startup_phases[8];
+static int num_startup_phases;
+static Uint64 startup_start, startup_last;
+
+// Record the end of a phase of startup.
+
+static void StartupPhase(const char *name)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (num_startup_phases < (int) earrlen(startup_phases))
+    {
+        startup_phases[num_startup_phases].name = name;
+        startup_phases[num_startup_phases].ticks = now - startup_last;
+        ++num_startup_phases;
+    }
+
+    startup_last = now;
+}
+
+static void PrintStartupTimes(void)
+{
+    double ms_per_tick = 1000.0 / SDL_GetPerformanceFrequency();
+    int i;
+
+    //!
+    // Print how long each phase of startup took.
+    //
+
+    if (!M_FindArgument("-startuptime"))
+    {
+        return;
+    }
+
+    for (i = 0; i < num_startup_phases; ++i)
+    {
+        printf("%-20s %8.2f ms\n", startup_phases[i].name,
+               startup_phases[i].ticks * ms_per_tick);
+    }
+
+    printf("%-20s %8.2f ms\n", "Total",
+           (startup_last - startup_start) * ms_per_tick);
+}
+
 // Initialize the textscreen library.
 
 static void InitTextscreen(void)
@@ -429,7 +482,96 @@ void RestartTextscreen(void)
 
 static void RunGUI(void)
 {
+    //!
+    // Draw the GUI offscreen through a fixed script of dialogs, print how
+    // fast each was drawn, and exit.
+    //
+
+    int benchmark = M_FindArgument("-uibench");
+
+    //!
+    // Run the GUI on the terminal rather than in a window, for use over
+    // a remote shell.
+    //
+
+    int terminal = M_FindArgument("-terminal");
+
+    //!
+    // Draw the GUI offscreen, without a window. Only useful with -replay.
+    //
+
+    int offscreen = M_FindArgument("-offscreen");
+
+    int p;
+
+    // Nothing could ever close the windows, so it would never exit.
+
+    if (offscreen && !benchmark && M_GetArgParameters("-replay", 1) <= 0)
+    {
+        fprintf(stderr, "-offscreen can only be used with -replay\n");
+        hal_medialayer.exit();
+    }
+
+    if (benchmark || offscreen)
+    {
+        TXT_SetBackend(TXT_BACKEND_OFFSCREEN);
+    }
+    else if (terminal)
+    {
+        TXT_SetBackend(TXT_BACKEND_TERMINAL);
+    }
+
+    TRACE_BEGIN(trace);
     InitTextscreen();
+    TRACE_END(trace, "InitTextscreen");
+
+    StartupPhase("Video and window");
+    PrintStartupTimes();
+
+    if (benchmark)
+    {
+        RunUIBenchmark();
+        return;
+    }
+
+    //!
+    // @arg <file>
+    //
+    // Record key presses and mouse input to the given file, for playing
+    // back with -replay.
+    //
+
+    p = M_GetArgParameters("-record", 1);
+
+    if (p > 0 && !TXT_StartRecording(myargv[p]))
+    {
+        fprintf(stderr, "Failed to open %s for recording\n", myargv[p]);
+    }
+
+    //!
+    // @arg <file>
+    //
+    // Play back input recorded with -record, then print how long each
+    // event took to be drawn, and exit.
+    //
+
+    p = M_GetArgParameters("-replay", 1);
+
+    if (p > 0)
+    {
+        //!
+        // Play back input as fast as possible with -replay, rather
+        // than with the timing it was recorded with.
+        //
+
+        txt_replay_speed_t speed = M_FindArgument("-replayfast")
+                                 ? TXT_REPLAY_FAST : TXT_REPLAY_PACED;
+
+        if (!TXT_StartReplay(myargv[p], speed))
+        {
+            fprintf(stderr, "Failed to read recording %s\n", myargv[p]);
+        }
+    }
 
     TXT_GUIMainLoop();
 }
@@ -443,11 +585,57 @@ static void MissionSet(void)
 
 void D_DoomMain(void)
 {
-    // CALICO: init HAL
-    HAL_Init();
-    SDL2_InitHAL();
+    int p;
+
+    startup_start = startup_last = SDL_GetPerformanceCounter();
+
+    //!
+    // @arg <file>
+    //
+    // Record how long startup and drawing take, and write it to the
+    // given file on exit, for viewing in chrome://tracing or Perfetto.
+    //
+
+    p = M_GetArgParameters("-trace", 1);
+
+    if (p > 0)
+    {
+        E_TraceStart(myargv[p]);
+    }
+
+    {
+        TRACE_BEGIN(trace);
+
+        // CALICO: init HAL
+        HAL_Init();
+        SDL2_InitHAL();
+
+        TRACE_END(trace, "HAL_Init");
+    }
+
+    E_LogInit();
+
+    StartupPhase("Media layer");
+
+    {
+        TRACE_BEGIN(trace);
+        MissionSet();
+        TRACE_END(trace, "MissionSet");
+    }
+
+    StartupPhase("Configuration");
+
+    // Stand-in for the game when testing the configuration handoff
+    if (M_FindArgument("-cfgprint"))
+    {
+        RunConfigStandIn();
+        hal_medialayer.exit();
+    }
+
+    // Bring the list of IWADs up to date in the background
+    IWADScan_Start();
 
-    MissionSet();
+    StartupPhase("IWAD index");
 
     RunGUI();
 }
@@ -72,7 +72,7 @@ void ConfigMouse(TXT_UNCAST_ARG(widget), void *user_data)
 
     TXT_SetColumnWidths(window, 23, 10);
 
-    //TXT_SetWindowAction(window, TXT_HORIZ_CENTER, TestConfigAction());
+    TXT_SetWindowAction(window, TXT_HORIZ_CENTER, TestConfigAction());
     TXT_SetWindowHelpURL(window, WINDOW_HELP_URL);
 
     TXT_AddWidgets(
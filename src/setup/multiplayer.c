@@ -25,6 +25,10 @@
 #include "multiplayer.h"
 #include "mode.h"
 #include "execute.h"
+#include "iwadscan.h"
+#include "loadorder.h"
+#include "prefetch.h"
+#include "../elib/wadfile.h"
 
 #define MULTI_START_HELP_URL "https://www.chocolate-doom.org/setup-multi-start"
 #define MULTI_JOIN_HELP_URL "https://www.chocolate-doom.org/setup-multi-join"
@@ -58,7 +62,7 @@ static const iwad_t fallback_iwads[] = {
 static const iwad_t **found_iwads;
 static const char   **iwad_labels;
 
-// Index of the currently selected IWAD
+// Index of the currently selected IWAD in found_iwads
 
 static int found_iwad_selected = -1;
 
@@ -83,6 +87,7 @@ static char *net_player_name;
 static char *chat_macros[10];
 
 static char *wads[NUM_WADS];
+static txt_label_t *wad_status[NUM_WADS];
 static char *extra_params[NUM_EXTRA_PARAMS];
 static int character_class = 0;
 static int skill = 2;
@@ -127,6 +132,7 @@ static void AddWADs(execute_context_t *exec)
             if (!have_wads)
             {
                 AddCmdLineParameter(exec, "-file");
+                have_wads = 1;
             }
 
             AddCmdLineParameter(exec, "\"%s\"", wads[i]);
@@ -155,19 +161,110 @@ static void AddIWADParameter(execute_context_t *exec)
     }
 }
 
-void ShowLaunchError(void)
+void ShowLaunchError(const char *message)
 {
     txt_window_t *window;
+    txt_window_action_t *log_action;
 
     window = TXT_NewWindow("Execution error");
-    TXT_AddWidget(window, TXT_NewLabel("Could not start the game."));
+    TXT_AddWidget(window, TXT_NewLabel(message));
+
+    log_action = TXT_NewWindowAction('l', "View log");
+    TXT_SignalConnect(log_action, "pressed", ShowLaunchLog, NULL);
 
     TXT_SetWindowAction(window, TXT_HORIZ_LEFT,  NULL);
-    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, NULL);
+    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, log_action);
 
     TXT_SetWindowAction(window, TXT_HORIZ_CENTER, TXT_NewWindowEscapeAction(window));
 }
 
+// Invoked from the main loop when the game launched by LaunchGame exits.
+
+static void GameExited(int result, void *user_data)
+{
+    txt_window_t *window = user_data;
+
+    TXT_CloseWindow(window);
+
+    // The game ran, however it exited; only report it if it was killed.
+
+    if (result >= 0)
+    {
+        // Shut down textscreen GUI
+        TXT_Shutdown();
+        hal_medialayer.exit();
+    }
+    else
+    {
+        ShowLaunchError("The game was killed.");
+    }
+}
+
+static int GameRunningKeyPress(txt_window_t *window, int key, void *user_data)
+{
+    // Nothing can be done until the game exits.
+    return 1;
+}
+
+// Launch the game with the given parameters. The setup GUI keeps running
+// while the game does, and shuts down once it exits.
+
+void LaunchGame(execute_context_t *exec)
+{
+    txt_window_t *window;
+
+    window = TXT_MessageBox(NULL, "The game is running.");
+    TXT_SetWindowAction(window, TXT_HORIZ_CENTER, NULL);
+    TXT_SetKeyListener(window, GameRunningKeyPress, NULL);
+
+    if (ExecuteDoom(exec, GameExited, window) < 0)
+    {
+        TXT_CloseWindow(window);
+        ShowLaunchError("Could not start the game.");
+    }
+}
+
+// Check that a WAD file is valid, and explain why not if it isn't.
+
+static int CheckWAD(const char *path)
+{
+    waderror_t error;
+
+    error = Wad_Check(path);
+
+    if (error != WAD_OK)
+    {
+        TXT_MessageBox("Invalid WAD", "%s:\n%s.", path,
+                       Wad_ErrorString(error));
+        return 0;
+    }
+
+    return 1;
+}
+
+// Check the IWAD and any added WADs before starting the game, so that
+// a bad file is reported here rather than by the game failing to start.
+
+static int CheckWADs(void)
+{
+    int i;
+
+    if (iwadfile != NULL && !CheckWAD(iwadfile))
+    {
+        return 0;
+    }
+
+    for (i=0; i<NUM_WADS; ++i)
+    {
+        if (wads[i] != NULL && strlen(wads[i]) > 0 && !CheckWAD(wads[i]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 // Callback function invoked to launch the game.
 // This is used when starting a server and also when starting a
 // single player game via the "warp" menu.
@@ -176,6 +273,11 @@ static void StartGame(int multiplayer)
 {
     execute_context_t *exec;
 
+    if (!CheckWADs())
+    {
+        return;
+    }
+
     exec = NewExecuteContext();
 
     // Extra parameters come first, before all others; this way,
@@ -243,19 +345,11 @@ static void StartGame(int multiplayer)
 
     AddWADs(exec);
 
-    Cfg_WriteFile();
+    SaveConfigForLaunch(exec);
     WriteEEProm();
     PassThroughArguments(exec);
 
-    if(ExecuteDoom(exec) >= 0)
-    {
-        TXT_Shutdown();
-        hal_medialayer.exit();
-    }
-    else
-    {
-        ShowLaunchError();
-    }
+    LaunchGame(exec);
 }
 
 static void StartServerGame(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(unused))
@@ -365,6 +459,31 @@ static void LevelSelectDialog(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(user_data))
     }
 }
 
+// Start reading the selected IWAD and PWADs into memory while the user
+// carries on, so that the game starts faster.
+
+static void PrefetchWADs(void)
+{
+    const char *paths[NUM_WADS + 1];
+    int num_paths = 0;
+    int i;
+
+    if (iwadfile != NULL)
+    {
+        paths[num_paths++] = iwadfile;
+    }
+
+    for (i=0; i<NUM_WADS; ++i)
+    {
+        if (wads[i] != NULL && strlen(wads[i]) > 0)
+        {
+            paths[num_paths++] = wads[i];
+        }
+    }
+
+    Prefetch_Start(paths, num_paths);
+}
+
 static void IWADSelected(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(unused))
 {
     const iwad_t *iwad;
@@ -376,6 +495,8 @@ static void IWADSelected(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(unused))
     // Update iwadfile
 
     iwadfile = iwad->filename;
+
+    PrefetchWADs();
 }
 
 // Called when the IWAD button is changed, to update warptype.
@@ -414,29 +535,31 @@ static const iwad_t **GetFallbackIwadList(void)
     return fallback_iwad_list;
 }
 
+// Get the IWADs found by the background scan, or those recorded in the
+// index until it has finished.
+
 static const iwad_t **GetIwads(void)
 {
-    static const iwad_t *local_found_iwads[3];
+    static iwad_t *scanned_iwads;
+    static const iwad_t **local_found_iwads;
+    const iwadinfo_t *const *list;
+    size_t count;
 
-    // CALICO_TODO: this sucks; eventually let the user choose an IWAD from the filesystem.
-    size_t count = 0;
-    for(size_t i = 0; i < earrlen(fallback_iwads); i++)
-    {
-        if(hal_platform.fileExists(fallback_iwads[i].filename))
-            ++count;
-    }
+    list = IWADScan_GetIWADs();
 
-    if(!count)
-    {
-        local_found_iwads[0] = NULL;
-        return local_found_iwads;
-    }
+    for (count = 0; list[count] != NULL; ++count);
+
+    free(scanned_iwads);
+    free(local_found_iwads);
 
-    for(size_t i = 0, j = 0; i < earrlen(fallback_iwads); i++, j++)
+    scanned_iwads = malloc(sizeof(*scanned_iwads) * (count + 1));
+    local_found_iwads = malloc(sizeof(*local_found_iwads) * (count + 1));
+
+    for (size_t i = 0; i < count; ++i)
     {
-        if(j >= count)
-            break;
-        local_found_iwads[j] = &fallback_iwads[i];
+        scanned_iwads[i].filename = list[i]->path;
+        scanned_iwads[i].game = list[i]->description;
+        local_found_iwads[i] = &scanned_iwads[i];
     }
     local_found_iwads[count] = NULL;
 
@@ -496,13 +619,20 @@ static txt_widget_t *IWADSelector(void)
         result = (txt_widget_t *) dropdown;
     }
 
-    // The first time the dialog is opened, found_iwad_selected=-1,
-    // so select the first IWAD in the list. Don't lose the setting
-    // if we close and reopen the dialog.
+    // Don't lose the setting if we close and reopen the dialog. The list
+    // may have changed since, once the background scan has finished, so
+    // find the IWAD selected before by its path. The first time the
+    // dialog is opened, or if it is gone, select the first in the list.
 
-    if (found_iwad_selected < 0 || (unsigned int)found_iwad_selected >= num_iwads)
+    found_iwad_selected = 0;
+
+    for (i=0; iwadfile != NULL && i < num_iwads; ++i)
     {
-        found_iwad_selected = 0;
+        if (!strcmp(found_iwads[i]->filename, iwadfile))
+        {
+            found_iwad_selected = i;
+            break;
+        }
     }
 
     IWADSelected(NULL, NULL);
@@ -535,20 +665,66 @@ static txt_window_action_t *StartGameAction(int multiplayer)
     return action;
 }
 
+// Show whether a file selected in the "Add WADs" window is valid.
+
+static void WadChanged(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(wad))
+{
+    TXT_CAST_ARG(char *, wad);
+    txt_label_t *status = wad_status[wad - wads];
+    waderror_t error;
+
+    PrefetchWADs();
+
+    if (*wad == NULL || strlen(*wad) == 0)
+    {
+        TXT_SetLabel(status, "");
+        return;
+    }
+
+    error = Wad_Check(*wad);
+
+    if (error == WAD_OK)
+    {
+        TXT_SetLabel(status, "OK");
+        TXT_SetFGColor(status, TXT_COLOR_GREEN);
+    }
+    else
+    {
+        TXT_SetLabel(status, Wad_ErrorString(error));
+        TXT_SetFGColor(status, TXT_COLOR_BRIGHT_RED);
+    }
+}
+
+static void AnalyzeLoadOrder(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(user_data))
+{
+    ShowLoadOrderReport(iwadfile, wads, NUM_WADS);
+}
+
 static void OpenWadsWindow(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(user_data))
 {
     txt_window_t *window;
+    txt_window_action_t *load_order;
     int i;
 
     window = TXT_NewWindow("Add WADs");
+    TXT_SetTableColumns(window, 2);
 
     for (i=0; i<NUM_WADS; ++i)
     {
-        TXT_AddWidget(
-            window,
-            TXT_NewFileSelector(&wads[i], 60, "Select a WAD file", wad_extensions)
-        );
+        txt_fileselect_t *fileselect;
+
+        fileselect = TXT_NewFileSelector(&wads[i], 40, "Select a WAD file",
+                                         wad_extensions);
+        wad_status[i] = TXT_NewLabel("");
+        TXT_SignalConnect(fileselect, "changed", WadChanged, &wads[i]);
+        TXT_AddWidgets(window, fileselect, wad_status[i], NULL);
+
+        WadChanged(NULL, &wads[i]);
     }
+
+    load_order = TXT_NewWindowAction('l', "Load order");
+    TXT_SignalConnect(load_order, "pressed", AnalyzeLoadOrder, NULL);
+    TXT_SetWindowAction(window, TXT_HORIZ_RIGHT, load_order);
 }
 
 static void OpenExtraParamsWindow(TXT_UNCAST_ARG(widget), 
@@ -724,20 +900,12 @@ static void DoJoinGame(void *unused1, void *unused2)
     AddIWADParameter(exec);
     AddWADs(exec);
 
-    Cfg_WriteFile();
+    SaveConfigForLaunch(exec);
     WriteEEProm();
 
     PassThroughArguments(exec);
 
-    if(ExecuteDoom(exec) >= 0)
-    {
-        TXT_Shutdown();
-        hal_medialayer.exit();
-    }
-    else
-    {
-        ShowLaunchError();
-    }
+    LaunchGame(exec);
 }
 
 static txt_window_action_t *JoinGameAction(void)
@@ -15,11 +15,14 @@
 #ifndef SETUP_MULTIPLAYER_H
 #define SETUP_MULTIPLAYER_H
 
+#include "execute.h"
+
 void StartMultiGame(void *widget, void *user_data);
 void WarpMenu(void *widget, void *user_data);
 void JoinMultiGame(void *widget, void *user_data);
 void MultiplayerConfig(void *widget, void *user_data);
-void ShowLaunchError(void);
+void ShowLaunchError(const char *message);
+void LaunchGame(execute_context_t *exec);
 
 #endif /* #ifndef SETUP_MULTIPLAYER_H */
 
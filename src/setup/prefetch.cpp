@@ -0,0 +1,347 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+
+// Prefetching of the selected IWAD and PWADs.
+//
+// Cold starts of the game are dominated by reading the IWAD, and we
+// know which file it will be long before the game is launched. While
+// the user carries on configuring, a background thread with the lowest
+// CPU and I/O priority reads the selected files into the page cache.
+// Changing the selection abandons the files being read.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "../elib/elib.h"
+#include "../elib/atexit.h"
+#include "../elib/configfile.h"
+#include "../elib/log.h"
+#include "../elib/qstring.h"
+#include "prefetch.h"
+
+#define PREFETCH_CHUNK_SIZE (4 * 1024 * 1024)
+
+// If false, files are not prefetched, but how much of them was cached
+// is still reported at launch.
+
+static bool prefetch_wads = true;
+
+static CfgItem cfgPrefetchWads("prefetch_wads", &prefetch_wads);
+
+static std::mutex              prefetch_lock;
+static std::condition_variable prefetch_cond;
+static std::thread             prefetch_thread;
+static std::vector<qstring>    selected_files;
+static std::vector<qstring>    prefetch_files;      // still to be read
+static std::atomic<unsigned>   prefetch_generation; // changed to cancel
+static bool                    prefetch_stopped;
+
+static bool Cancelled(unsigned int generation)
+{
+    return prefetch_generation != generation;
+}
+
+static void LowerPriority(void)
+{
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+    // Idle I/O class and the lowest CPU priority, for this thread only.
+
+    const int ioprio_who_process = 1, ioprio_class_idle = 3;
+
+    syscall(SYS_ioprio_set, ioprio_who_process, 0, ioprio_class_idle << 13);
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#elif defined(__APPLE__)
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_THROTTLE);
+#endif
+}
+
+// Read a file through in chunks, stopping if the selection changes.
+// Each chunk is first requested as a whole, so the disk sees one large
+// read rather than a series of small ones; reading it then waits for it
+// to arrive, so that there is never more than one chunk in flight.
+
+static void PrefetchFile(const qstring &path, unsigned int generation)
+{
+    std::unique_ptr<char []> buffer { new char [PREFETCH_CHUNK_SIZE] };
+
+#ifdef _WIN32
+    HANDLE file;
+    DWORD len;
+
+    file = CreateFileA(path.constPtr(), GENERIC_READ, FILE_SHARE_READ,
+                       nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                       nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        E_LOG(LOGLEVEL_WARNING, "prefetch", "Cannot open %s", path.constPtr());
+        return;
+    }
+
+    while (!Cancelled(generation))
+    {
+        if (!ReadFile(file, buffer.get(), PREFETCH_CHUNK_SIZE, &len, nullptr)
+         || len == 0)
+        {
+            break;
+        }
+    }
+
+    CloseHandle(file);
+#else
+    struct stat st;
+    int fd;
+
+    fd = open(path.constPtr(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        E_LOG(LOGLEVEL_WARNING, "prefetch", "Cannot open %s", path.constPtr());
+        return;
+    }
+
+    if (fstat(fd, &st) == 0)
+    {
+        for (off_t offset = 0; offset < st.st_size && !Cancelled(generation);
+             offset += PREFETCH_CHUNK_SIZE)
+        {
+            size_t len = static_cast<size_t>(
+                std::min<off_t>(st.st_size - offset, PREFETCH_CHUNK_SIZE));
+
+#if defined(__linux__)
+            readahead(fd, offset, len);
+#elif defined(__APPLE__)
+            struct radvisory ra = { offset, static_cast<int>(len) };
+            fcntl(fd, F_RDADVISE, &ra);
+#else
+            posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
+#endif
+
+            if (pread(fd, buffer.get(), len, offset) <= 0)
+            {
+                break;
+            }
+        }
+    }
+
+    close(fd);
+#endif
+}
+
+static void PrefetchThread(void)
+{
+    std::unique_lock<std::mutex> lock(prefetch_lock);
+    unsigned int generation;
+
+    LowerPriority();
+
+    for (;;)
+    {
+        prefetch_cond.wait(lock, [&] {
+            return prefetch_stopped || !prefetch_files.empty();
+        });
+
+        if (prefetch_stopped)
+        {
+            return;
+        }
+
+        std::vector<qstring> files;
+
+        files.swap(prefetch_files);
+        generation = prefetch_generation;
+
+        lock.unlock();
+
+        for (const qstring &path : files)
+        {
+            if (Cancelled(generation))
+            {
+                break;
+            }
+
+            PrefetchFile(path, generation);
+
+            E_LOG(LOGLEVEL_DEBUG, "prefetch", "%s %s", Cancelled(generation)
+                  ? "Cancelled" : "Read", path.constPtr());
+        }
+
+        lock.lock();
+    }
+}
+
+static void StopPrefetch(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(prefetch_lock);
+        prefetch_stopped = true;
+        ++prefetch_generation;
+        prefetch_cond.notify_all();
+    }
+
+    if (prefetch_thread.joinable())
+    {
+        prefetch_thread.join();
+    }
+}
+
+void Prefetch_Start(const char *const *paths, int num_paths)
+{
+    std::lock_guard<std::mutex> guard(prefetch_lock);
+
+    selected_files.clear();
+
+    for (int i = 0; i < num_paths; ++i)
+    {
+        selected_files.push_back(qstring(paths[i]));
+    }
+
+    if (!prefetch_wads || prefetch_stopped)
+    {
+        return;
+    }
+
+    prefetch_files = selected_files;
+    ++prefetch_generation;
+
+    if (!prefetch_thread.joinable())
+    {
+        prefetch_thread = std::thread(PrefetchThread);
+        E_AtExit(StopPrefetch, true);
+    }
+
+    prefetch_cond.notify_all();
+}
+
+// Count the bytes of a file that are in the page cache.
+
+static bool GetResident(const qstring &path, unsigned long long &resident,
+                        unsigned long long &total)
+{
+#ifdef _WIN32
+    // There is no way to ask Windows this.
+    return false;
+#else
+    std::vector<unsigned char> pages;
+    size_t page_size, size;
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(path.constPtr(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    size = static_cast<size_t>(st.st_size);
+    map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+
+    page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    pages.resize((size + page_size - 1) / page_size);
+
+#if defined(__APPLE__)
+    bool ok = mincore(map, size, reinterpret_cast<char *>(pages.data())) == 0;
+#else
+    bool ok = mincore(map, size, pages.data()) == 0;
+#endif
+
+    munmap(map, size);
+
+    if (!ok)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        if (pages[i] & 1)
+        {
+            resident += std::min(page_size, size - i * page_size);
+        }
+    }
+
+    total += size;
+
+    return true;
+#endif
+}
+
+int Prefetch_Finish(unsigned long long *resident, unsigned long long *total)
+{
+    std::vector<qstring> files;
+
+    {
+        std::lock_guard<std::mutex> guard(prefetch_lock);
+        prefetch_files.clear();
+        ++prefetch_generation;
+        files = selected_files;
+    }
+
+    *resident = 0;
+    *total = 0;
+
+    for (const qstring &path : files)
+    {
+        if (!GetResident(path, *resident, *total))
+        {
+            return 0;
+        }
+    }
+
+    return !files.empty();
+}
+
@@ -0,0 +1,35 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+
+#pragma once
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Start reading the given files into the page cache in the background,
+// abandoning any files that were being read for an earlier selection.
+
+void Prefetch_Start(const char *const *paths, int num_paths);
+
+// Stop reading, and find how many bytes of the selected files are now
+// cached. Returns zero if this cannot be determined.
+
+int Prefetch_Finish(unsigned long long *resident, unsigned long long *total);
+
+#if defined(__cplusplus)
+}
+#endif
+
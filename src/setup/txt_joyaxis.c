@@ -432,7 +432,6 @@ static void TXT_JoystickAxisDrawer(TXT_UNCAST_ARG(joystick_axis))
 #if DEADCODE
     TXT_CAST_ARG(txt_joystick_axis_t, joystick_axis);
     char buf[JOYSTICK_AXIS_WIDTH + 1];
-    int i;
 
     if (*joystick_axis->axis < 0)
     {
@@ -466,10 +465,8 @@ static void TXT_JoystickAxisDrawer(TXT_UNCAST_ARG(joystick_axis))
 
     TXT_DrawString(buf);
 
-    for (i = TXT_UTF8_Strlen(buf); i < joystick_axis->widget.w; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', (int) joystick_axis->widget.w
+                    - (int) TXT_UTF8_Strlen(buf));
 #endif
 }
 
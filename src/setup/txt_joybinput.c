@@ -211,6 +211,15 @@ static void OpenPromptWindow(txt_joystick_input_t *joystick_input)
 
     joystick_input->check_conflicts = !TXT_GetModifierState(TXT_MOD_SHIFT);
 
+    // Controller events are only read in a window.
+
+    if (TXT_GetBackend() == TXT_BACKEND_TERMINAL)
+    {
+        TXT_MessageBox(NULL, "Controller buttons can't be set from a\n"
+                             "terminal. Run setup in a window instead.");
+        return;
+    }
+
     if (SDL_Init(SDL_INIT_JOYSTICK) < 0)
     {
         return;
@@ -260,7 +269,6 @@ static void TXT_JoystickInputDrawer(TXT_UNCAST_ARG(joystick_input))
 {
     TXT_CAST_ARG(txt_joystick_input_t, joystick_input);
     char buf[20];
-    int i;
 
     if (*joystick_input->variable < 0)
     {
@@ -277,10 +285,7 @@ static void TXT_JoystickInputDrawer(TXT_UNCAST_ARG(joystick_input))
 
     TXT_DrawString(buf);
 
-    for (i = TXT_UTF8_Strlen(buf); i < JOYSTICK_INPUT_WIDTH; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', JOYSTICK_INPUT_WIDTH - (int) TXT_UTF8_Strlen(buf));
 }
 
 static void TXT_JoystickInputDestructor(TXT_UNCAST_ARG(joystick_input))
@@ -133,7 +133,6 @@ static void TXT_KeyInputSizeCalc(TXT_UNCAST_ARG(key_input))
 static void TXT_KeyInputDrawer(TXT_UNCAST_ARG(key_input))
 {
     TXT_CAST_ARG(txt_key_input_t, key_input);
-    int i;
 
     const char *const current_binding = Calico_GetCurrentKeyBinding(key_input->key);
 
@@ -142,10 +141,7 @@ static void TXT_KeyInputDrawer(TXT_UNCAST_ARG(key_input))
 
     TXT_DrawString(current_binding);
 
-    for (i = TXT_UTF8_Strlen(current_binding); i < KEY_INPUT_WIDTH; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', KEY_INPUT_WIDTH - (int) TXT_UTF8_Strlen(current_binding));
 }
 
 static void TXT_KeyInputDestructor(TXT_UNCAST_ARG(key_input))
@@ -92,7 +92,6 @@ static void TXT_MouseInputDrawer(TXT_UNCAST_ARG(mouse_input))
 {
     TXT_CAST_ARG(txt_mouse_input_t, mouse_input);
     char buf[20];
-    int i;
 
     if (*mouse_input->variable < 0)
     {
@@ -108,10 +107,7 @@ static void TXT_MouseInputDrawer(TXT_UNCAST_ARG(mouse_input))
     
     TXT_DrawString(buf);
     
-    for (i = TXT_UTF8_Strlen(buf); i < MOUSE_INPUT_WIDTH; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', MOUSE_INPUT_WIDTH - (int) TXT_UTF8_Strlen(buf));
 }
 
 static void TXT_MouseInputDestructor(TXT_UNCAST_ARG(mouse_input))
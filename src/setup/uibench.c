@@ -0,0 +1,153 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// UI benchmark: step through a fixed script of dialogs on the offscreen
+// textscreen backend, and report how fast each was drawn. The hash of
+// the final screen of each step is printed too, so that runs can be
+// compared against known-good screens.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../elib/elib.h"
+#include "../elib/m_argv.h"
+#include "doomkeys.h"
+#include "textscreen.h"
+#include "txt_perf.h"
+#include "m_misc.h"
+
+#include "display.h"
+#include "joystick.h"
+#include "keyboard.h"
+#include "uibench.h"
+
+// Frames drawn for each step of the script.
+
+#define BENCH_FRAMES 500
+
+typedef struct
+{
+    const char *name;
+    const char *filename;       // for -uibenchdump
+    TxtWidgetSignalFunc open;   // NULL to use the window already open
+} bench_step_t;
+
+static const bench_step_t bench_steps[] =
+{
+    { "Main menu", "mainmenu.ppm", NULL           },
+    { "Display",   "display.ppm",  ConfigDisplay  },
+    { "Keyboard",  "keyboard.ppm", ConfigKeyboard },
+    { "Gamepad",   "gamepad.ppm",  ConfigJoystick },
+};
+
+// Keys pressed in turn, one per frame, to move around the window.
+
+static const int bench_keys[] =
+{
+    KEY_DOWNARROW, KEY_DOWNARROW, KEY_DOWNARROW, KEY_DOWNARROW,
+    KEY_UPARROW,   KEY_UPARROW,   KEY_UPARROW,   KEY_UPARROW,
+    KEY_TAB,       KEY_TAB,
+};
+
+static void RunStep(const bench_step_t *step, const char *dump_dir,
+                    double *total_time, unsigned int *total_allocs)
+{
+    txt_window_t *window;
+    Uint64 start, ticks;
+    unsigned int allocs;
+    double seconds;
+    int i;
+
+    if (step->open != NULL)
+    {
+        step->open(NULL, NULL);
+    }
+
+    window = TXT_GetActiveWindow();
+
+    allocs = txt_perf_counters[TXT_PERF_ALLOCS];
+    start = SDL_GetPerformanceCounter();
+
+    for (i = 0; i < BENCH_FRAMES; ++i)
+    {
+        TXT_WindowKeyPress(window, bench_keys[i % earrlen(bench_keys)]);
+        TXT_DrawDesktop();
+    }
+
+    ticks = SDL_GetPerformanceCounter() - start;
+    allocs = txt_perf_counters[TXT_PERF_ALLOCS] - allocs;
+    seconds = (double) ticks / SDL_GetPerformanceFrequency();
+
+    printf("%-10s %9.1f frames/sec %7.2f allocs/frame  hash %08x\n",
+           step->name, BENCH_FRAMES / seconds,
+           (double) allocs / BENCH_FRAMES, TXT_HashScreenImage());
+
+    if (dump_dir != NULL)
+    {
+        char *filename = M_StringJoin(dump_dir, DIR_SEPARATOR_S,
+                                      step->filename, NULL);
+
+        if (!TXT_SaveScreenImage(filename))
+        {
+            fprintf(stderr, "Failed to write %s\n", filename);
+        }
+
+        free(filename);
+    }
+
+    *total_time += seconds;
+    *total_allocs += allocs;
+
+    if (step->open != NULL)
+    {
+        TXT_CloseWindow(window);
+    }
+}
+
+void RunUIBenchmark(void)
+{
+    const char *dump_dir = NULL;
+    unsigned int total_allocs = 0;
+    double total_time = 0;
+    int num_frames;
+    int i;
+    int p;
+
+    //!
+    // @arg <directory>
+    //
+    // With -uibench, write the last screen of each step of the benchmark
+    // to a PPM image in the given directory.
+    //
+
+    p = M_GetArgParameters("-uibenchdump", 1);
+
+    if (p > 0)
+    {
+        dump_dir = myargv[p];
+    }
+
+    for (i = 0; i < (int) earrlen(bench_steps); ++i)
+    {
+        RunStep(&bench_steps[i], dump_dir, &total_time, &total_allocs);
+    }
+
+    num_frames = BENCH_FRAMES * (int) earrlen(bench_steps);
+
+    printf("%-10s %9.1f frames/sec %7.2f allocs/frame\n", "Total",
+           num_frames / total_time, (double) total_allocs / num_frames);
+}
+
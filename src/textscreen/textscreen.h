@@ -40,10 +40,13 @@ typedef uint8_t byte;
 #include "txt_conditional.h"
 #include "txt_desktop.h"
 #include "txt_dropdown.h"
+#include "txt_filebrowser.h"
 #include "txt_fileselect.h"
 #include "txt_inputbox.h"
 #include "txt_label.h"
+#include "txt_process.h"
 #include "txt_radiobutton.h"
+#include "txt_replay.h"
 #include "txt_scrollpane.h"
 #include "txt_separator.h"
 #include "txt_spinctrl.h"
@@ -32,7 +32,6 @@ static void TXT_ButtonSizeCalc(TXT_UNCAST_ARG(button))
 static void TXT_ButtonDrawer(TXT_UNCAST_ARG(button))
 {
     TXT_CAST_ARG(txt_button_t, button);
-    int i;
     int w;
 
     w = button->widget.w;
@@ -41,10 +40,7 @@ static void TXT_ButtonDrawer(TXT_UNCAST_ARG(button))
 
     TXT_DrawString(button->label);
 
-    for (i = TXT_UTF8_Strlen(button->label); i < w; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', w - (int) TXT_UTF8_Strlen(button->label));
 }
 
 static void TXT_ButtonDestructor(TXT_UNCAST_ARG(button))
@@ -35,7 +35,6 @@ static void TXT_CheckBoxDrawer(TXT_UNCAST_ARG(checkbox))
 {
     TXT_CAST_ARG(txt_checkbox_t, checkbox);
     txt_saved_colors_t colors;
-    int i;
     int w;
 
     w = checkbox->widget.w;
@@ -63,10 +62,7 @@ static void TXT_CheckBoxDrawer(TXT_UNCAST_ARG(checkbox))
     TXT_SetWidgetBG(checkbox);
     TXT_DrawString(checkbox->label);
 
-    for (i = TXT_UTF8_Strlen(checkbox->label); i < w-4; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', w - 4 - (int) TXT_UTF8_Strlen(checkbox->label));
 }
 
 static void TXT_CheckBoxDestructor(TXT_UNCAST_ARG(checkbox))
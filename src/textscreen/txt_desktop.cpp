@@ -0,0 +1,611 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+#include <stddef.h>
+#include <string.h>
+
+#include "../elib/elib.h"
+#include "../elib/dllist.h"
+#include "../elib/trace.h"
+
+extern "C" {
+#include "doomkeys.h"
+#include "txt_desktop.h"
+#include "txt_gui.h"
+#include "txt_io.h"
+#include "txt_main.h"
+#include "txt_perf.h"
+#include "txt_process.h"
+#include "txt_replay.h"
+#include "txt_separator.h"
+#include "txt_window.h"
+}
+
+#define HELP_KEY KEY_F1
+
+// Windows are kept in a stack from the top down, linked through the
+// desktop_link of each, which is a C copy of a DLListItem.
+
+typedef DLListItem<txt_window_t> windowlink_t;
+
+static_assert(sizeof(windowlink_t) == sizeof(txt_window_link_t)
+           && offsetof(windowlink_t, dllNext) == offsetof(txt_window_link_t, next)
+           && offsetof(windowlink_t, dllPrev) == offsetof(txt_window_link_t, prev)
+           && offsetof(windowlink_t, dllObject) == offsetof(txt_window_link_t, object)
+           && offsetof(windowlink_t, dllData) == offsetof(txt_window_link_t, data),
+              "txt_window_link_t must match DLListItem<txt_window_t>");
+
+static char *desktop_title;
+static windowlink_t *window_stack;      // the top (active) window
+static windowlink_t *window_bottom;
+static int num_windows = 0;
+
+// Cells of the screen hidden by the frame of a window, as worked out for
+// the frame being drawn. Whether each window can be seen at all is kept
+// in the dllData of its link.
+static unsigned char covered[TXT_SCREEN_H][TXT_SCREEN_W];
+static int main_loop_running = 0;
+
+static TxtIdleCallback periodic_callback = NULL;
+static void *periodic_callback_data;
+static unsigned int periodic_callback_period;
+
+static windowlink_t *WindowLink(txt_window_t *window)
+{
+    return reinterpret_cast<windowlink_t *>(&window->desktop_link);
+}
+
+// Get the link of the window above, or NULL for the top window. dllPrev
+// points to the dllNext of the link above, which is its first member.
+
+static windowlink_t *LinkAbove(windowlink_t *link)
+{
+    if (link->dllPrev == &window_stack)
+    {
+        return nullptr;
+    }
+
+    return reinterpret_cast<windowlink_t *>(link->dllPrev);
+}
+
+void TXT_AddDesktopWindow(txt_window_t *win)
+{
+    windowlink_t *link = WindowLink(win);
+
+    // Previously-top window loses focus:
+
+    if (window_stack != nullptr)
+    {
+        TXT_SetWindowFocus(window_stack->dllObject, 0);
+    }
+
+    link->insert(win, &window_stack);
+
+    if (window_bottom == nullptr)
+    {
+        window_bottom = link;
+    }
+
+    ++num_windows;
+
+    // New window gains focus:
+
+    TXT_SetWindowFocus(win, 1);
+}
+
+void TXT_RemoveDesktopWindow(txt_window_t *win)
+{
+    windowlink_t *link = WindowLink(win);
+
+    // Window must lose focus if it's being removed:
+
+    TXT_SetWindowFocus(win, 0);
+
+    if (link->dllPrev != nullptr)
+    {
+        if (window_bottom == link)
+        {
+            window_bottom = LinkAbove(link);
+        }
+
+        link->remove();
+        --num_windows;
+    }
+
+    // Top window gains focus:
+
+    if (window_stack != nullptr)
+    {
+        TXT_SetWindowFocus(window_stack->dllObject, 1);
+    }
+}
+
+txt_window_t *TXT_GetActiveWindow(void)
+{
+    if (window_stack == nullptr)
+    {
+        return NULL;
+    }
+
+    return window_stack->dllObject;
+}
+
+int TXT_RaiseWindow(txt_window_t *window)
+{
+    windowlink_t *link = WindowLink(window);
+    windowlink_t *above;
+    windowlink_t **slot;
+
+    // Window not in the list, or at the top already?
+
+    if (link->dllPrev == nullptr || (above = LinkAbove(link)) == nullptr)
+    {
+        return 0;
+    }
+
+    // Move in front of the window above.
+
+    if (window_bottom == link)
+    {
+        window_bottom = above;
+    }
+
+    slot = above->dllPrev;
+    link->remove();
+    link->insert(window, slot);
+
+    if (slot == &window_stack)
+    {
+        TXT_SetWindowFocus(above->dllObject, 0);
+        TXT_SetWindowFocus(window, 1);
+    }
+
+    return 1;
+}
+
+int TXT_LowerWindow(txt_window_t *window)
+{
+    windowlink_t *link = WindowLink(window);
+    windowlink_t *below = link->dllNext;
+    bool was_top;
+
+    // Window not in the list, or at the bottom already?
+
+    if (link->dllPrev == nullptr || below == nullptr)
+    {
+        return 0;
+    }
+
+    // Move behind the window below.
+
+    was_top = link->dllPrev == &window_stack;
+
+    if (window_bottom == below)
+    {
+        window_bottom = link;
+    }
+
+    link->remove();
+    link->insert(window, &below->dllNext);
+
+    if (was_top)
+    {
+        TXT_SetWindowFocus(window, 0);
+        TXT_SetWindowFocus(below->dllObject, 1);
+    }
+
+    return 1;
+}
+
+static void DrawDesktopBackground(const char *title)
+{
+    int x, y, run;
+
+    // Fill the screen with gradient characters, except where windows
+    // will be drawn over it anyway.
+
+    TXT_FGColor(TXT_COLOR_GREY);
+    TXT_BGColor(TXT_COLOR_BLUE, 0);
+
+    for (y = 1; y < TXT_SCREEN_H - 1; ++y)
+    {
+        for (x = 0; x < TXT_SCREEN_W; x += run)
+        {
+            for (run = 0; x + run < TXT_SCREEN_W
+                       && covered[y][x + run] == covered[y][x]; ++run);
+
+            if (covered[y][x])
+            {
+                TXT_PerfCount(TXT_PERF_CULLED, run);
+            }
+            else
+            {
+                TXT_FillRect(x, y, run, 1, 0xb1);
+            }
+        }
+    }
+
+    // Draw the top and bottom banners
+
+    TXT_FGColor(TXT_COLOR_BLACK);
+    TXT_BGColor(TXT_COLOR_GREY, 0);
+    TXT_FillRect(0, 0, TXT_SCREEN_W, 1, ' ');
+    TXT_FillRect(0, TXT_SCREEN_H - 1, TXT_SCREEN_W, 1, ' ');
+
+    // Print the title
+
+    TXT_GotoXY(0, 0);
+
+    TXT_PutChar(' ');
+    TXT_Puts(title);
+
+    TXT_DrawPerfHUD();
+}
+
+static void DrawHelpIndicator(void)
+{
+    char keybuf[10];
+    txt_color_t fgcolor;
+    int x, y;
+
+    TXT_GetKeyDescription(HELP_KEY, keybuf, sizeof(keybuf));
+
+    TXT_GetMousePosition(&x, &y);
+
+    if (y == 0 && x >= TXT_SCREEN_W - 9)
+    {
+        fgcolor = TXT_COLOR_GREY;
+        TXT_BGColor(TXT_COLOR_BLACK, 0);
+    }
+    else
+    {
+        fgcolor = TXT_COLOR_BLACK;
+        TXT_BGColor(TXT_COLOR_GREY, 0);
+    }
+
+    TXT_GotoXY(TXT_SCREEN_W - 9, 0);
+
+    TXT_FGColor(TXT_COLOR_BRIGHT_WHITE);
+    TXT_DrawString(" ");
+    TXT_DrawString(keybuf);
+
+    TXT_FGColor(fgcolor);
+    TXT_DrawString("=Help ");
+}
+
+void TXT_SetDesktopTitle(const char *title)
+{
+    free(desktop_title);
+    desktop_title = estrdup(title);
+    TXT_SetWindowTitle(title);
+}
+
+// Clip a rectangle to the screen. Returns zero if none of it is on it.
+
+static int ClipToScreen(int *x1, int *y1, int *x2, int *y2)
+{
+    if (*x1 < 0)
+        *x1 = 0;
+    if (*y1 < 0)
+        *y1 = 0;
+    if (*x2 > TXT_SCREEN_W)
+        *x2 = TXT_SCREEN_W;
+    if (*y2 > TXT_SCREEN_H)
+        *y2 = TXT_SCREEN_H;
+
+    return *x1 < *x2 && *y1 < *y2;
+}
+
+static int RectCovered(int x, int y, int w, int h)
+{
+    int x1 = x, y1 = y, x2 = x + w, y2 = y + h;
+
+    if (!ClipToScreen(&x1, &y1, &x2, &y2))
+    {
+        return 1;
+    }
+
+    for (y = y1; y < y2; ++y)
+    {
+        for (x = x1; x < x2; ++x)
+        {
+            if (!covered[y][x])
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void CoverRect(int x, int y, int w, int h)
+{
+    int x1 = x, y1 = y, x2 = x + w, y2 = y + h;
+
+    if (ClipToScreen(&x1, &y1, &x2, &y2))
+    {
+        for (y = y1; y < y2; ++y)
+        {
+            memset(&covered[y][x1], 1, x2 - x1);
+        }
+    }
+}
+
+// Lay out the windows from the top down, and work out which of them are
+// hidden by the windows above. A window's frame is drawn over everything
+// inside it, so hides what is below; its shadow only darkens what is
+// below, so it hides nothing, but it must be uncovered to be seen.
+
+static void CullWindows(void)
+{
+    windowlink_t *link;
+    txt_window_t *window;
+    int x, y, w, h;
+
+    memset(covered, 0, sizeof(covered));
+
+    for (link = window_stack; link != nullptr; link = link->dllNext)
+    {
+        window = link->dllObject;
+
+        TXT_LayoutWindow(window);
+
+        x = window->window_x;
+        y = window->window_y;
+        w = window->window_w;
+        h = window->window_h;
+
+        link->dllData = !RectCovered(x, y, w, h)
+                     || !RectCovered(x + 2, y + h, w, 1)
+                     || !RectCovered(x + w, y + 1, 2, h);
+
+        if (!link->dllData)
+        {
+            TXT_PerfCount(TXT_PERF_CULLED, w * h);
+        }
+
+        CoverRect(x, y, w, h);
+    }
+}
+
+void TXT_DrawDesktop(void)
+{
+    txt_window_t *active_window;
+    const char *title;
+    unsigned int start;
+    windowlink_t *link;
+
+    TRACE_BEGIN(trace);
+
+    TXT_InitClipArea();
+
+    if (desktop_title == NULL)
+        title = "";
+    else
+        title = desktop_title;
+
+    start = TXT_PerfTime();
+
+    CullWindows();
+
+    DrawDesktopBackground(title);
+
+    active_window = TXT_GetActiveWindow();
+    if (active_window != NULL && active_window->help_url != NULL)
+    {
+        DrawHelpIndicator();
+    }
+
+    for (link = window_bottom; link != nullptr; link = LinkAbove(link))
+    {
+        if (link->dllData)
+        {
+            TXT_DrawLaidOutWindow(link->dllObject);
+        }
+    }
+
+    TXT_PerfCount(TXT_PERF_LAYOUT, TXT_PerfTime() - start);
+
+    TXT_UpdateScreen();
+    TXT_ReplayPresented();
+
+    TRACE_END(trace, "TXT_DrawDesktop");
+}
+
+// Fallback function to handle key/mouse events that are not handled by
+// the active window.
+static void DesktopInputEvent(int c)
+{
+    txt_window_t *active_window;
+    int x, y;
+
+    switch (c)
+    {
+        case TXT_MOUSE_LEFT:
+            TXT_GetMousePosition(&x, &y);
+
+            // Clicking the top-right of the screen is equivalent
+            // to pressing the help key.
+            if (y == 0 && x >= TXT_SCREEN_W - 9)
+            {
+                DesktopInputEvent(HELP_KEY);
+            }
+            break;
+
+        case HELP_KEY:
+            active_window = TXT_GetActiveWindow();
+            if (active_window != NULL)
+            {
+                TXT_OpenWindowHelpURL(active_window);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+
+}
+
+static void DispatchEvent(int c)
+{
+    txt_window_t *active_window;
+
+    TXT_PerfCount(TXT_PERF_EVENTS, 1);
+
+    if (c == TXT_PERF_HUD_KEY)
+    {
+        TXT_TogglePerfHUD();
+        return;
+    }
+
+    active_window = TXT_GetActiveWindow();
+
+    if (active_window != NULL && !TXT_WindowKeyPress(active_window, c))
+    {
+        DesktopInputEvent(c);
+    }
+}
+
+void TXT_DispatchEvents(void)
+{
+    int c;
+
+    // While replaying, input from the user is read but thrown away.
+
+    if (TXT_Replaying())
+    {
+        while (TXT_GetChar() >= 0);
+
+        while ((c = TXT_ReplayNextEvent()) > 0)
+        {
+            DispatchEvent(c);
+        }
+
+        return;
+    }
+
+    while ((c = TXT_GetChar()) >= 0)
+    {
+        TXT_RecordEvent(c);
+
+        // Stop at mouse movement, so hover is redrawn.
+
+        if (c == 0)
+        {
+            break;
+        }
+
+        DispatchEvent(c);
+    }
+}
+
+void TXT_ExitMainLoop(void)
+{
+    main_loop_running = 0;
+}
+
+void TXT_DrawASCIITable(void)
+{
+    unsigned char *screendata;
+    char buf[10];
+    int x, y;
+    int n;
+
+    screendata = TXT_GetScreenData();
+
+    TXT_FGColor(TXT_COLOR_BRIGHT_WHITE);
+    TXT_BGColor(TXT_COLOR_BLACK, 0);
+
+    for (y=0; y<16; ++y)
+    {
+        for (x=0; x<16; ++x)
+        {
+            n = y * 16 + x;
+
+            TXT_GotoXY(x * 5, y);
+            TXT_snprintf(buf, sizeof(buf), "%02x   ", n);
+            TXT_Puts(buf);
+
+            // Write the character directly to the screen memory buffer:
+
+            screendata[(y * TXT_SCREEN_W + x * 5 + 3) * 2] = n;
+        }
+    }
+
+    TXT_UpdateScreen();
+}
+
+void TXT_SetPeriodicCallback(TxtIdleCallback callback,
+                             void *user_data,
+                             unsigned int period)
+{
+    periodic_callback = callback;
+    periodic_callback_data = user_data;
+    periodic_callback_period = period;
+}
+
+void TXT_GUIMainLoop(void)
+{
+    main_loop_running = 1;
+
+    while (main_loop_running)
+    {
+        unsigned int start = TXT_PerfTime();
+
+        TXT_DispatchEvents();
+
+        // Deliver output and exit notifications from child processes.
+
+        TXT_PollProcesses();
+
+        // After the last window is closed, exit the loop
+
+        if (num_windows <= 0)
+        {
+            TXT_ExitMainLoop();
+            continue;
+        }
+
+        TXT_DrawDesktop();
+//        TXT_DrawASCIITable();
+
+        TXT_PerfCount(TXT_PERF_FRAME, TXT_PerfTime() - start);
+        TXT_PerfEndFrame();
+
+        if (TXT_Replaying())
+        {
+            // Wait only until the next event is due.
+
+            TXT_ReplayWait();
+
+            if (periodic_callback != NULL)
+            {
+                periodic_callback(periodic_callback_data);
+            }
+        }
+        else if (periodic_callback == NULL)
+        {
+            TXT_Sleep(0);
+        }
+        else
+        {
+            TXT_Sleep(periodic_callback_period);
+
+            periodic_callback(periodic_callback_data);
+        }
+    }
+}
+
@@ -29,7 +29,10 @@ void TXT_AddDesktopWindow(txt_window_t *win);
 void TXT_RemoveDesktopWindow(txt_window_t *win);
 void TXT_DrawDesktop(void);
 void TXT_DispatchEvents(void);
+void TXT_LayoutWindow(txt_window_t *window);
 void TXT_DrawWindow(txt_window_t *window);
+// Draw a window that TXT_LayoutWindow() has already been called for.
+void TXT_DrawLaidOutWindow(txt_window_t *window);
 void TXT_SetWindowFocus(txt_window_t *window, int focused);
 int TXT_WindowKeyPress(txt_window_t *window, int c);
 
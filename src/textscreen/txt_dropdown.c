@@ -12,9 +12,11 @@
 // GNU General Public License for more details.
 //
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../elib/elib.h"
 #include "doomkeys.h"
 #include "txt_button.h"
 #include "txt_dropdown.h"
@@ -32,6 +34,26 @@ typedef struct
     int item;
 } callback_data_t;
 
+#define SEARCH_LEN 32
+
+// An open selector window.
+
+typedef struct
+{
+    txt_dropdown_list_t *list;
+    txt_table_t *table;
+    txt_scrollpane_t *pane;
+    txt_button_t **buttons;
+
+    // Text typed so far, and the values that contain it, in list order.
+    // The buttons for the other values are hidden.
+
+    char search[SEARCH_LEN];
+    size_t search_len;
+    int *matches;
+    int num_matches;
+} selector_t;
+
 // Check if the selected value for a list is valid
 
 static int ValidSelection(txt_dropdown_list_t *list)
@@ -95,13 +117,273 @@ static void FreeCallbackData(TXT_UNCAST_ARG(list),
     free(callback_data);
 }
 
-// Catch presses of escape and close the window.
+static void FreeSelector(TXT_UNCAST_ARG(window), TXT_UNCAST_ARG(selector))
+{
+    TXT_CAST_ARG(selector_t, selector);
+
+    free(selector->buttons);
+    free(selector->matches);
+    free(selector);
+}
+
+// Sorted index of the values, for finding the values that begin with
+// the text typed.
+
+static const char **sort_values;
+
+static int CompareValues(const void *a, const void *b)
+{
+    int i1 = *(const int *) a;
+    int i2 = *(const int *) b;
+    int result;
+
+    result = strcasecmp(sort_values[i1], sort_values[i2]);
+
+    return result != 0 ? result : i1 - i2;
+}
+
+static void UpdateSortedIndex(txt_dropdown_list_t *list)
+{
+    int i;
+
+    // The values can be changed in place by the caller, so check that the
+    // index is still in order.
+
+    sort_values = list->values;
+
+    if (list->num_sorted == list->num_values)
+    {
+        for (i = 1; i < list->num_sorted; ++i)
+        {
+            if (CompareValues(&list->sorted[i - 1], &list->sorted[i]) > 0)
+            {
+                break;
+            }
+        }
+
+        if (i >= list->num_sorted)
+        {
+            return;
+        }
+    }
+
+    list->sorted = realloc(list->sorted, (list->num_values + 1) * sizeof(int));
+    list->num_sorted = list->num_values;
+
+    for (i = 0; i < list->num_values; ++i)
+    {
+        list->sorted[i] = i;
+    }
+
+    qsort(list->sorted, list->num_sorted, sizeof(int), CompareValues);
+}
+
+// Find the first value in the list that begins with the text typed, or
+// -1 if there is none.
+
+static int FindPrefix(selector_t *selector)
+{
+    txt_dropdown_list_t *list = selector->list;
+    int lo, hi, mid;
+    int result;
+
+    lo = 0;
+    hi = list->num_sorted;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+
+        if (strncasecmp(list->values[list->sorted[mid]], selector->search,
+                        selector->search_len) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    // The values beginning with the text all follow in the index; find
+    // the one that comes first in the list.
+
+    result = -1;
+
+    for (; lo < list->num_sorted; ++lo)
+    {
+        mid = list->sorted[lo];
+
+        if (strncasecmp(list->values[mid], selector->search,
+                        selector->search_len) != 0)
+        {
+            break;
+        }
+
+        if (result < 0 || mid < result)
+        {
+            result = mid;
+        }
+    }
+
+    return result;
+}
+
+static int ContainsSearch(selector_t *selector, const char *value)
+{
+    if (selector->search_len == 0)
+    {
+        return 1;
+    }
+
+    for (; *value != '\0'; ++value)
+    {
+        if (!strncasecmp(value, selector->search, selector->search_len))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void ShowSelection(selector_t *selector)
+{
+    if (selector->pane != NULL)
+    {
+        TXT_ScrollPaneShowSelectedWidget(selector->pane);
+    }
+}
+
+// Add a character to the text typed. Only the values that matched before
+// can match now, so only those are checked.
+
+static void NarrowSearch(selector_t *selector, int key)
+{
+    txt_dropdown_list_t *list = selector->list;
+    int i, n, item;
+
+    if (selector->search_len + 1 >= SEARCH_LEN)
+    {
+        return;
+    }
+
+    selector->search[selector->search_len++] = (char) key;
+    selector->search[selector->search_len] = '\0';
+
+    // Ignore the character if nothing would be left.
+
+    for (i = 0; i < selector->num_matches; ++i)
+    {
+        if (ContainsSearch(selector, list->values[selector->matches[i]]))
+        {
+            break;
+        }
+    }
+
+    if (i >= selector->num_matches)
+    {
+        selector->search[--selector->search_len] = '\0';
+        return;
+    }
+
+    n = 0;
+
+    for (i = 0; i < selector->num_matches; ++i)
+    {
+        item = selector->matches[i];
+
+        if (ContainsSearch(selector, list->values[item]))
+        {
+            selector->matches[n++] = item;
+        }
+        else
+        {
+            selector->buttons[item]->widget.visible = 0;
+        }
+    }
+
+    selector->num_matches = n;
+
+    // Jump to the first value that begins with the text, or else the
+    // first that contains it.
+
+    item = FindPrefix(selector);
+
+    if (item < 0)
+    {
+        item = selector->matches[0];
+    }
+
+    TXT_SelectWidget(selector->table, selector->buttons[item]);
+    ShowSelection(selector);
+}
+
+// Remove the last characters of the text typed, so that there are len
+// left, and show the values that match again.
+
+static void WidenSearch(selector_t *selector, size_t len)
+{
+    txt_dropdown_list_t *list = selector->list;
+    int i;
+
+    selector->search_len = len;
+    selector->search[len] = '\0';
+    selector->num_matches = 0;
+
+    for (i = 0; i < list->num_values; ++i)
+    {
+        if (ContainsSearch(selector, list->values[i]))
+        {
+            selector->matches[selector->num_matches++] = i;
+            selector->buttons[i]->widget.visible = 1;
+        }
+        else
+        {
+            selector->buttons[i]->widget.visible = 0;
+        }
+    }
+
+    ShowSelection(selector);
+}
+
+// Type to search the list. Escape clears the text typed, or closes the
+// window if there is none.
 
 static int SelectorWindowListener(txt_window_t *window, int key, void *user_data)
 {
+    selector_t *selector = user_data;
+
     if (key == KEY_ESCAPE)
     {
-        TXT_CloseWindow(window);
+        if (selector->search_len > 0)
+        {
+            WidenSearch(selector, 0);
+        }
+        else
+        {
+            TXT_CloseWindow(window);
+        }
+
+        return 1;
+    }
+
+    if (key == KEY_BACKSPACE)
+    {
+        if (selector->search_len > 0)
+        {
+            WidenSearch(selector, selector->search_len - 1);
+        }
+
+        return 1;
+    }
+
+    // Values can contain spaces, but not start with them.
+
+    if (key >= ' ' && key < 127 && isprint(key)
+     && (key != ' ' || selector->search_len > 0))
+    {
+        NarrowSearch(selector, key);
         return 1;
     }
 
@@ -153,6 +435,7 @@ static int DropdownListWidth(txt_dropdown_list_t *list)
 static void OpenSelectorWindow(txt_dropdown_list_t *list)
 {
     txt_window_t *window;
+    selector_t *selector;
     int i;
 
     // Open a simple window with no title bar or action buttons.
@@ -186,6 +469,18 @@ static void OpenSelectorWindow(txt_dropdown_list_t *list)
         parent_widget = table;
     }
 
+    selector = malloc(sizeof(selector_t));
+    selector->list = list;
+    selector->table = parent_widget;
+    selector->pane = pane;
+    selector->buttons = malloc((list->num_values + 1) * sizeof(txt_button_t *));
+    selector->search[0] = '\0';
+    selector->search_len = 0;
+    selector->matches = malloc((list->num_values + 1) * sizeof(int));
+    selector->num_matches = list->num_values;
+
+    UpdateSortedIndex(list);
+
     // Add a button to the window for each option in the list.
 
     for (i=0; i<list->num_values; ++i)
@@ -197,6 +492,9 @@ static void OpenSelectorWindow(txt_dropdown_list_t *list)
 
         TXT_AddWidget(parent_widget, button);
 
+        selector->buttons[i] = button;
+        selector->matches[i] = i;
+
         // Callback struct
 
         data = malloc(sizeof(callback_data_t));
@@ -225,9 +523,11 @@ static void OpenSelectorWindow(txt_dropdown_list_t *list)
         }
     }
 
-    // Catch presses of escape in this window and close it.
+    TXT_SignalConnect(window, "closed", FreeSelector, selector);
 
-    TXT_SetKeyListener(window, SelectorWindowListener, NULL);
+    // Catch typing and presses of escape in this window.
+
+    TXT_SetKeyListener(window, SelectorWindowListener, selector);
     TXT_SetMouseListener(window, SelectorMouseListener, NULL);
 }
 
@@ -265,14 +565,19 @@ static void TXT_DropdownListDrawer(TXT_UNCAST_ARG(list))
 
     TXT_DrawString(str);
 
-    for (i = TXT_UTF8_Strlen(str); i < list->widget.w; ++i)
+    i = TXT_UTF8_Strlen(str);
+
+    if (i < list->widget.w)
     {
-        TXT_DrawString(" ");
+        TXT_FillSpan(' ', list->widget.w - i);
     }
 }
 
 static void TXT_DropdownListDestructor(TXT_UNCAST_ARG(list))
 {
+    TXT_CAST_ARG(txt_dropdown_list_t, list);
+
+    free(list->sorted);
 }
 
 static int TXT_DropdownListKeyPress(TXT_UNCAST_ARG(list), int key)
@@ -323,6 +628,8 @@ txt_dropdown_list_t *TXT_NewDropdownList(int *variable, const char **values,
     list->variable = variable;
     list->values = values;
     list->num_values = num_values;
+    list->sorted = NULL;
+    list->num_sorted = 0;
 
     return list;
 }
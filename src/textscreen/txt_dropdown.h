@@ -29,6 +29,11 @@
  *
  * When the value of a dropdown list is changed, the "changed" signal
  * is emitted.
+ *
+ * Typing while the list is open hides the values that do not contain
+ * the text typed so far, ignoring case, and selects the first value
+ * that begins with it. Backspace removes the last character typed and
+ * escape clears the text.
  */
 
 typedef struct txt_dropdown_list_s txt_dropdown_list_t;
@@ -45,6 +50,12 @@ struct txt_dropdown_list_s
     int *variable;
     const char **values;
     int num_values;
+
+    // Indexes of the values in case-insensitive order, for finding them
+    // by what is typed in the selector window. Rebuilt when the selector
+    // is opened if the values have changed.
+    int *sorted;
+    int num_sorted;
 };
 
 /**
@@ -0,0 +1,1430 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Built-in directory browser window. Directories are enumerated on a
+// worker thread and streamed into a list widget that only draws the
+// rows currently on screen.
+//
+
+#include "SDL.h"
+
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#include "../elib/elib.h"
+#include "doomkeys.h"
+#include "txt_filebrowser.h"
+#include "txt_fileselect.h"
+#include "txt_gui.h"
+#include "txt_io.h"
+#include "txt_label.h"
+#include "txt_main.h"
+#include "txt_term.h"
+#include "txt_utf8.h"
+#include "txt_widget.h"
+#include "txt_window.h"
+#include "txt_window_action.h"
+
+// Size of the list in characters. The rightmost column holds the
+// scrollbar.
+
+#define FILELIST_W          56
+#define FILELIST_H          15
+
+// Number of entries the worker thread collects before handing them over
+// to the UI thread.
+
+#define SCAN_BATCH_SIZE     64
+
+// Number of directory listings to keep in the cache.
+
+#define MAX_CACHED_DIRS     8
+
+// Time in ms after which a type-ahead search starts again from scratch.
+
+#define TYPEAHEAD_TIMEOUT   1000
+#define TYPEAHEAD_LEN       32
+
+typedef struct
+{
+    char *name;
+    int is_dir;
+} txt_direntry_t;
+
+// Contents of a directory. Once a listing has been read completely it
+// is placed in the cache, which owns it from then on.
+
+typedef struct
+{
+    char *path;
+    time_t mtime;
+    txt_direntry_t *entries;
+    int num_entries;
+    int max_entries;
+    int refcount;
+    int cached;
+    unsigned int last_used;
+} txt_dirlisting_t;
+
+// State shared between the UI thread and a directory scanning thread.
+// Everything after 'path' is protected by 'lock'. The UI thread gives
+// up a job by setting 'abandoned'; whichever side sees the other one is
+// done with it frees the job.
+
+typedef struct
+{
+    SDL_mutex *lock;
+    char *path;
+    txt_direntry_t *pending;
+    int num_pending;
+    int max_pending;
+    int finished;
+    int abandoned;
+} scan_job_t;
+
+typedef struct
+{
+    txt_widget_t widget;
+
+    txt_window_t *window;
+    txt_label_t *path_label;
+    txt_label_t *status_label;
+
+    const char **extensions;
+    TxtFileBrowserCallback callback;
+    void *user_data;
+
+    // Directory being shown, and its contents so far.
+
+    char *path;
+    txt_dirlisting_t *listing;
+    scan_job_t *job;
+
+    // Indexes into listing->entries of entries that pass the filter.
+    // 'filtered' is the number of entries that have been considered.
+
+    int *visible;
+    int num_visible;
+    int max_visible;
+    int filtered;
+
+    int selected;
+    int top;
+
+    // Name of an entry to select once it has been read.
+
+    char *select_name;
+
+    char typeahead[TYPEAHEAD_LEN];
+    unsigned int typeahead_time;
+} txt_filelist_t;
+
+static txt_dirlisting_t *dir_cache[MAX_CACHED_DIRS];
+static unsigned int cache_clock;
+
+// SDL event used by scanning threads to wake up the main loop.
+
+static Uint32 scan_event_type = (Uint32) -1;
+
+//
+// Paths
+//
+
+static int IsSeparator(char c)
+{
+#ifdef _WIN32
+    if (c == '\\')
+    {
+        return 1;
+    }
+#endif
+    return c == '/';
+}
+
+static int IsAbsolutePath(const char *path)
+{
+#ifdef _WIN32
+    if (path[0] != '\0' && path[1] == ':')
+    {
+        return 1;
+    }
+#endif
+    return IsSeparator(path[0]);
+}
+
+static char *JoinPath(const char *dir, const char *name)
+{
+    size_t dir_len, len;
+    char *result;
+
+    dir_len = strlen(dir);
+    len = dir_len + strlen(name) + 2;
+    result = malloc(len);
+
+    if (dir_len > 0 && IsSeparator(dir[dir_len - 1]))
+    {
+        TXT_snprintf(result, len, "%s%s", dir, name);
+    }
+    else
+    {
+        TXT_snprintf(result, len, "%s/%s", dir, name);
+    }
+
+    return result;
+}
+
+// Returns a newly-allocated string containing the parent directory of
+// the given path, or NULL if the path is a root directory.
+
+static char *ParentPath(const char *path)
+{
+    size_t len, i;
+    char *result;
+
+    len = strlen(path);
+
+    while (len > 1 && IsSeparator(path[len - 1]))
+    {
+        --len;
+    }
+
+    for (i = len; i > 0 && !IsSeparator(path[i - 1]); --i);
+
+    if (i == 0 || i == len)
+    {
+        return NULL;
+    }
+
+    // Keep the separator if the parent is the root directory.
+
+    len = i - 1;
+
+    if (len == 0 || (len == 2 && path[1] == ':'))
+    {
+        ++len;
+    }
+
+    result = malloc(len + 1);
+    memcpy(result, path, len);
+    result[len] = '\0';
+
+    return result;
+}
+
+// Returns a pointer to the last component of the given path.
+
+static const char *BaseName(const char *path)
+{
+    const char *p;
+
+    for (p = path + strlen(path); p > path; --p)
+    {
+        if (IsSeparator(p[-1]))
+        {
+            break;
+        }
+    }
+
+    return p;
+}
+
+static char *CurrentDirectory(void)
+{
+    char buf[4096];
+
+    if (getcwd(buf, sizeof(buf)) == NULL)
+    {
+        return estrdup(".");
+    }
+
+    return estrdup(buf);
+}
+
+// Returns true if the given path is a directory, optionally returning
+// its modification time.
+
+static int IsDirectory(const char *path, time_t *mtime)
+{
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+    {
+        return 0;
+    }
+
+    if (mtime != NULL)
+    {
+        *mtime = st.st_mtime;
+    }
+
+    return (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+//
+// Directory listings and the listing cache
+//
+
+static void AddEntry(txt_direntry_t **entries, int *num_entries,
+                     int *max_entries, const txt_direntry_t *entry)
+{
+    if (*num_entries >= *max_entries)
+    {
+        *max_entries = *max_entries ? *max_entries * 2 : SCAN_BATCH_SIZE;
+        *entries = realloc(*entries, *max_entries * sizeof(txt_direntry_t));
+    }
+
+    (*entries)[*num_entries] = *entry;
+    ++*num_entries;
+}
+
+static txt_dirlisting_t *NewListing(const char *path, time_t mtime)
+{
+    txt_dirlisting_t *listing;
+    char *parent;
+
+    listing = calloc(1, sizeof(txt_dirlisting_t));
+    listing->path = estrdup(path);
+    listing->mtime = mtime;
+    listing->refcount = 1;
+
+    // Every directory except the root gets a ".." entry to go up a level.
+
+    parent = ParentPath(path);
+
+    if (parent != NULL)
+    {
+        txt_direntry_t entry;
+
+        entry.name = estrdup("..");
+        entry.is_dir = 1;
+        AddEntry(&listing->entries, &listing->num_entries,
+                 &listing->max_entries, &entry);
+        free(parent);
+    }
+
+    return listing;
+}
+
+static void FreeListing(txt_dirlisting_t *listing)
+{
+    int i;
+
+    for (i = 0; i < listing->num_entries; ++i)
+    {
+        free(listing->entries[i].name);
+    }
+
+    free(listing->entries);
+    free(listing->path);
+    free(listing);
+}
+
+static void ReleaseListing(txt_dirlisting_t *listing)
+{
+    --listing->refcount;
+
+    if (listing->refcount <= 0 && !listing->cached)
+    {
+        FreeListing(listing);
+    }
+}
+
+static void RemoveCacheSlot(int slot)
+{
+    txt_dirlisting_t *listing = dir_cache[slot];
+
+    dir_cache[slot] = NULL;
+    listing->cached = 0;
+
+    if (listing->refcount <= 0)
+    {
+        FreeListing(listing);
+    }
+}
+
+// Look up a directory in the cache. Listings are only reused if the
+// directory has not been modified since it was read.
+
+static txt_dirlisting_t *LookupCache(const char *path, time_t mtime)
+{
+    int i;
+
+    for (i = 0; i < MAX_CACHED_DIRS; ++i)
+    {
+        txt_dirlisting_t *listing = dir_cache[i];
+
+        if (listing == NULL || strcmp(listing->path, path) != 0)
+        {
+            continue;
+        }
+
+        if (listing->mtime != mtime)
+        {
+            RemoveCacheSlot(i);
+            return NULL;
+        }
+
+        listing->last_used = ++cache_clock;
+        ++listing->refcount;
+        return listing;
+    }
+
+    return NULL;
+}
+
+static void AddToCache(txt_dirlisting_t *listing)
+{
+    int i, slot = -1;
+
+    for (i = 0; i < MAX_CACHED_DIRS; ++i)
+    {
+        if (dir_cache[i] == NULL)
+        {
+            slot = i;
+            break;
+        }
+
+        // Evict the least recently used listing that nobody is showing.
+
+        if (dir_cache[i]->refcount <= 0
+         && (slot < 0 || dir_cache[i]->last_used < dir_cache[slot]->last_used))
+        {
+            slot = i;
+        }
+    }
+
+    if (slot < 0)
+    {
+        return;
+    }
+
+    if (dir_cache[slot] != NULL)
+    {
+        RemoveCacheSlot(slot);
+    }
+
+    dir_cache[slot] = listing;
+    listing->cached = 1;
+    listing->last_used = ++cache_clock;
+}
+
+// Directories first, then case-insensitive alphabetical order.
+
+static int CompareEntries(const void *a, const void *b)
+{
+    const txt_direntry_t *e1 = a, *e2 = b;
+
+    if (!strcmp(e1->name, ".."))
+    {
+        return -1;
+    }
+    if (!strcmp(e2->name, ".."))
+    {
+        return 1;
+    }
+    if (e1->is_dir != e2->is_dir)
+    {
+        return e2->is_dir - e1->is_dir;
+    }
+
+    return strcasecmp(e1->name, e2->name);
+}
+
+//
+// Scanning thread
+//
+
+static void WakeMainLoop(void)
+{
+    SDL_Event ev;
+
+    SDL_zero(ev);
+    ev.type = scan_event_type;
+    SDL_PushEvent(&ev);
+    TXT_Term_Wake();
+}
+
+static void FreeEntries(txt_direntry_t *entries, int num_entries)
+{
+    int i;
+
+    for (i = 0; i < num_entries; ++i)
+    {
+        free(entries[i].name);
+    }
+}
+
+static void FreeJob(scan_job_t *job)
+{
+    FreeEntries(job->pending, job->num_pending);
+    free(job->pending);
+    free(job->path);
+    SDL_DestroyMutex(job->lock);
+    free(job);
+}
+
+// Hand a batch of entries over to the UI thread. If 'last' is set, the
+// job is marked as finished. Returns false if the job was abandoned, in
+// which case the job has been freed.
+
+static int FlushBatch(scan_job_t *job, txt_direntry_t *batch, int *num_batch,
+                      int last)
+{
+    int i;
+
+    SDL_LockMutex(job->lock);
+
+    if (job->abandoned)
+    {
+        SDL_UnlockMutex(job->lock);
+        FreeEntries(batch, *num_batch);
+        *num_batch = 0;
+        FreeJob(job);
+        return 0;
+    }
+
+    for (i = 0; i < *num_batch; ++i)
+    {
+        AddEntry(&job->pending, &job->num_pending, &job->max_pending,
+                 &batch[i]);
+    }
+
+    *num_batch = 0;
+    job->finished = last;
+
+    SDL_UnlockMutex(job->lock);
+
+    WakeMainLoop();
+
+    return 1;
+}
+
+#ifdef _WIN32
+
+static int ScanDirectory(scan_job_t *job, txt_direntry_t *batch,
+                         int *num_batch)
+{
+    WIN32_FIND_DATAA data;
+    HANDLE handle;
+    char *pattern;
+
+    pattern = JoinPath(job->path, "*");
+    handle = FindFirstFileA(pattern, &data);
+    free(pattern);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return 1;
+    }
+
+    do
+    {
+        if (data.cFileName[0] == '.'
+         || (data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0)
+        {
+            continue;
+        }
+
+        batch[*num_batch].name = estrdup(data.cFileName);
+        batch[*num_batch].is_dir =
+            (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        ++*num_batch;
+
+        if (*num_batch >= SCAN_BATCH_SIZE
+         && !FlushBatch(job, batch, num_batch, 0))
+        {
+            FindClose(handle);
+            return 0;
+        }
+    } while (FindNextFileA(handle, &data));
+
+    FindClose(handle);
+
+    return 1;
+}
+
+#else
+
+static int EntryIsDirectory(const char *dir, const struct dirent *de)
+{
+    char *path;
+    int result;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+    // Most filesystems tell us the type directly, which saves a stat()
+    // call per entry.
+
+    if (de->d_type == DT_DIR)
+    {
+        return 1;
+    }
+    else if (de->d_type != DT_UNKNOWN && de->d_type != DT_LNK)
+    {
+        return 0;
+    }
+#endif
+
+    path = JoinPath(dir, de->d_name);
+    result = IsDirectory(path, NULL);
+    free(path);
+
+    return result;
+}
+
+static int ScanDirectory(scan_job_t *job, txt_direntry_t *batch,
+                         int *num_batch)
+{
+    struct dirent *de;
+    DIR *dir;
+
+    dir = opendir(job->path);
+
+    if (dir == NULL)
+    {
+        return 1;
+    }
+
+    while ((de = readdir(dir)) != NULL)
+    {
+        // Skip ".", ".." and hidden files.
+
+        if (de->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        batch[*num_batch].name = estrdup(de->d_name);
+        batch[*num_batch].is_dir = EntryIsDirectory(job->path, de);
+        ++*num_batch;
+
+        if (*num_batch >= SCAN_BATCH_SIZE
+         && !FlushBatch(job, batch, num_batch, 0))
+        {
+            closedir(dir);
+            return 0;
+        }
+    }
+
+    closedir(dir);
+
+    return 1;
+}
+
+#endif
+
+static int ScanThread(void *data)
+{
+    scan_job_t *job = data;
+    txt_direntry_t batch[SCAN_BATCH_SIZE];
+    int num_batch = 0;
+
+    if (ScanDirectory(job, batch, &num_batch))
+    {
+        FlushBatch(job, batch, &num_batch, 1);
+    }
+
+    return 0;
+}
+
+static scan_job_t *StartScan(const char *path)
+{
+    scan_job_t *job;
+    SDL_Thread *thread;
+
+    job = calloc(1, sizeof(scan_job_t));
+    job->lock = SDL_CreateMutex();
+    job->path = estrdup(path);
+
+    thread = SDL_CreateThread(ScanThread, "txt_dirscan", job);
+
+    if (thread != NULL)
+    {
+        SDL_DetachThread(thread);
+    }
+    else
+    {
+        // No threads; read the whole directory now.
+
+        ScanThread(job);
+    }
+
+    return job;
+}
+
+static void AbandonScan(scan_job_t *job)
+{
+    int finished;
+
+    SDL_LockMutex(job->lock);
+    finished = job->finished;
+    job->abandoned = 1;
+    SDL_UnlockMutex(job->lock);
+
+    // If the thread is done, it won't look at the job again.
+
+    if (finished)
+    {
+        FreeJob(job);
+    }
+}
+
+//
+// File list widget
+//
+
+static int HasExtension(const char *name, const char **extensions)
+{
+    const char *ext;
+    int i;
+
+    if (extensions == NULL)
+    {
+        return 1;
+    }
+
+    ext = strrchr(name, '.');
+
+    if (ext == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; extensions[i] != NULL; ++i)
+    {
+        if (!strcasecmp(ext + 1, extensions[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int EntryVisible(txt_filelist_t *list, const txt_direntry_t *entry)
+{
+    if (entry->is_dir)
+    {
+        return 1;
+    }
+
+    return list->extensions != TXT_DIRECTORY
+        && HasExtension(entry->name, list->extensions);
+}
+
+static txt_direntry_t *SelectedEntry(txt_filelist_t *list)
+{
+    if (list->selected < 0 || list->selected >= list->num_visible)
+    {
+        return NULL;
+    }
+
+    return &list->listing->entries[list->visible[list->selected]];
+}
+
+static void SetSelection(txt_filelist_t *list, int selected)
+{
+    if (selected >= list->num_visible)
+    {
+        selected = list->num_visible - 1;
+    }
+    if (selected < 0)
+    {
+        selected = 0;
+    }
+
+    list->selected = selected;
+
+    // Scroll so that the selection is on screen.
+
+    if (list->selected < list->top)
+    {
+        list->top = list->selected;
+    }
+    else if (list->selected >= list->top + FILELIST_H)
+    {
+        list->top = list->selected - FILELIST_H + 1;
+    }
+}
+
+static void ScrollList(txt_filelist_t *list, int lines)
+{
+    int max_top;
+
+    max_top = list->num_visible - FILELIST_H;
+
+    list->top += lines;
+
+    if (list->top > max_top)
+    {
+        list->top = max_top;
+    }
+    if (list->top < 0)
+    {
+        list->top = 0;
+    }
+}
+
+// Run any new entries in the listing through the filter, and select the
+// pending entry if it has turned up.
+
+static void FilterNewEntries(txt_filelist_t *list)
+{
+    txt_dirlisting_t *listing = list->listing;
+    int i;
+
+    for (i = list->filtered; i < listing->num_entries; ++i)
+    {
+        if (!EntryVisible(list, &listing->entries[i]))
+        {
+            continue;
+        }
+
+        if (list->num_visible >= list->max_visible)
+        {
+            list->max_visible = list->max_visible ? list->max_visible * 2
+                                                  : SCAN_BATCH_SIZE;
+            list->visible = realloc(list->visible,
+                                    list->max_visible * sizeof(int));
+        }
+
+        list->visible[list->num_visible] = i;
+
+        if (list->select_name != NULL
+         && !strcmp(listing->entries[i].name, list->select_name))
+        {
+            SetSelection(list, list->num_visible);
+            free(list->select_name);
+            list->select_name = NULL;
+        }
+
+        ++list->num_visible;
+    }
+
+    list->filtered = listing->num_entries;
+}
+
+static void RefilterListing(txt_filelist_t *list)
+{
+    list->num_visible = 0;
+    list->filtered = 0;
+    FilterNewEntries(list);
+}
+
+// Pull in any entries the scanning thread has read since the last call.
+
+static void UpdateListing(txt_filelist_t *list)
+{
+    txt_dirlisting_t *listing = list->listing;
+    scan_job_t *job = list->job;
+    txt_direntry_t *selected;
+    char *selected_name;
+    int finished;
+    int i;
+
+    if (job == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(job->lock);
+
+    for (i = 0; i < job->num_pending; ++i)
+    {
+        AddEntry(&listing->entries, &listing->num_entries,
+                 &listing->max_entries, &job->pending[i]);
+    }
+
+    job->num_pending = 0;
+    finished = job->finished;
+
+    SDL_UnlockMutex(job->lock);
+
+    if (!finished)
+    {
+        FilterNewEntries(list);
+        return;
+    }
+
+    FreeJob(job);
+    list->job = NULL;
+
+    // Entries are shown in the order they arrive while reading; now that
+    // we have them all, sort them and keep the same entry selected.
+
+    selected = SelectedEntry(list);
+    selected_name = selected != NULL ? selected->name : NULL;
+
+    qsort(listing->entries, listing->num_entries, sizeof(txt_direntry_t),
+          CompareEntries);
+
+    RefilterListing(list);
+
+    for (i = 0; i < list->num_visible; ++i)
+    {
+        if (listing->entries[list->visible[i]].name == selected_name)
+        {
+            SetSelection(list, i);
+            break;
+        }
+    }
+
+    AddToCache(listing);
+}
+
+static void UpdatePathLabel(txt_filelist_t *list)
+{
+    unsigned int len;
+    char *buf;
+    size_t buf_len;
+
+    len = TXT_UTF8_Strlen(list->path);
+
+    if (len <= FILELIST_W)
+    {
+        TXT_SetLabel(list->path_label, list->path);
+        return;
+    }
+
+    // Too long; show the end of the path.
+
+    buf_len = strlen(list->path) + 4;
+    buf = malloc(buf_len);
+    TXT_snprintf(buf, buf_len, "...%s",
+                 TXT_UTF8_SkipChars(list->path, len - FILELIST_W + 3));
+    TXT_SetLabel(list->path_label, buf);
+    free(buf);
+}
+
+static void UpdateStatusLabel(txt_filelist_t *list)
+{
+    char buf[TYPEAHEAD_LEN + 32];
+
+    if (list->typeahead[0] != '\0'
+     && SDL_GetTicks() - list->typeahead_time < TYPEAHEAD_TIMEOUT)
+    {
+        TXT_snprintf(buf, sizeof(buf), "Find: %s", list->typeahead);
+    }
+    else if (list->job != NULL)
+    {
+        TXT_snprintf(buf, sizeof(buf), "Reading... %i entries",
+                     list->num_visible);
+    }
+    else
+    {
+        TXT_snprintf(buf, sizeof(buf), "%i entries", list->num_visible);
+    }
+
+    if (strcmp(list->status_label->label, buf) != 0)
+    {
+        TXT_SetLabel(list->status_label, buf);
+    }
+}
+
+static void CloseDirectory(txt_filelist_t *list)
+{
+    if (list->job != NULL)
+    {
+        AbandonScan(list->job);
+        list->job = NULL;
+    }
+
+    if (list->listing != NULL)
+    {
+        ReleaseListing(list->listing);
+        list->listing = NULL;
+    }
+}
+
+// Switch to the given directory. Takes ownership of 'path'.
+
+static void ChangeDirectory(txt_filelist_t *list, char *path)
+{
+    time_t mtime = 0;
+
+    CloseDirectory(list);
+
+    free(list->path);
+    list->path = path;
+    list->selected = 0;
+    list->top = 0;
+    list->typeahead[0] = '\0';
+
+    UpdatePathLabel(list);
+
+    IsDirectory(path, &mtime);
+
+    list->listing = LookupCache(path, mtime);
+
+    if (list->listing == NULL)
+    {
+        list->listing = NewListing(path, mtime);
+        list->job = StartScan(path);
+    }
+
+    RefilterListing(list);
+}
+
+static void GoToParent(txt_filelist_t *list)
+{
+    char *parent;
+
+    parent = ParentPath(list->path);
+
+    if (parent == NULL)
+    {
+        return;
+    }
+
+    // Select the directory we just came out of.
+
+    free(list->select_name);
+    list->select_name = estrdup(BaseName(list->path));
+
+    ChangeDirectory(list, parent);
+}
+
+static void ChoosePath(txt_filelist_t *list, char *path)
+{
+    list->callback(path, list->user_data);
+    free(path);
+
+    TXT_CloseWindow(list->window);
+}
+
+static void ActivateSelection(txt_filelist_t *list)
+{
+    txt_direntry_t *entry;
+    char *path;
+
+    entry = SelectedEntry(list);
+
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    if (!strcmp(entry->name, ".."))
+    {
+        GoToParent(list);
+        return;
+    }
+
+    path = JoinPath(list->path, entry->name);
+
+    if (entry->is_dir)
+    {
+        free(list->select_name);
+        list->select_name = NULL;
+        ChangeDirectory(list, path);
+    }
+    else
+    {
+        ChoosePath(list, path);
+    }
+}
+
+// Jump to the next entry beginning with the characters typed so far,
+// starting from the current selection.
+
+static void TypeAheadSearch(txt_filelist_t *list)
+{
+    size_t len;
+    int i, n;
+
+    len = strlen(list->typeahead);
+
+    for (n = 0; n < list->num_visible; ++n)
+    {
+        i = (list->selected + n) % list->num_visible;
+
+        if (!strncasecmp(list->listing->entries[list->visible[i]].name,
+                         list->typeahead, len))
+        {
+            SetSelection(list, i);
+            return;
+        }
+    }
+}
+
+static void TypeAheadKey(txt_filelist_t *list, int key)
+{
+    unsigned int now;
+    size_t len;
+
+    now = SDL_GetTicks();
+
+    if (now - list->typeahead_time >= TYPEAHEAD_TIMEOUT)
+    {
+        list->typeahead[0] = '\0';
+    }
+
+    list->typeahead_time = now;
+    len = strlen(list->typeahead);
+
+    if (len + 1 < TYPEAHEAD_LEN)
+    {
+        list->typeahead[len] = (char) key;
+        list->typeahead[len + 1] = '\0';
+    }
+
+    TypeAheadSearch(list);
+}
+
+static void TXT_FileListSizeCalc(TXT_UNCAST_ARG(list))
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+
+    list->widget.w = FILELIST_W;
+    list->widget.h = FILELIST_H;
+}
+
+static void DrawEntry(const txt_direntry_t *entry, unsigned int w)
+{
+    unsigned int len;
+    const char *end;
+    char *buf;
+
+    // Leave room for the trailing slash on directories.
+
+    if (entry->is_dir)
+    {
+        --w;
+    }
+
+    len = TXT_UTF8_Strlen(entry->name);
+
+    if (len > w)
+    {
+        end = TXT_UTF8_SkipChars(entry->name, w);
+        buf = malloc(end - entry->name + 1);
+        memcpy(buf, entry->name, end - entry->name);
+        buf[end - entry->name] = '\0';
+        TXT_DrawString(buf);
+        free(buf);
+        len = w;
+    }
+    else
+    {
+        TXT_DrawString(entry->name);
+    }
+
+    if (entry->is_dir)
+    {
+        TXT_DrawString("/");
+    }
+
+    if (len < w)
+    {
+        TXT_FillSpan(' ', w - len);
+    }
+}
+
+static void TXT_FileListDrawer(TXT_UNCAST_ARG(list))
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+    txt_saved_colors_t colors;
+    unsigned int w;
+    int origin_x, origin_y;
+    int y, i;
+
+    UpdateListing(list);
+    UpdateStatusLabel(list);
+
+    w = list->widget.w - 1;
+
+    TXT_GetXY(&origin_x, &origin_y);
+    TXT_SaveColors(&colors);
+
+    // Only the rows on screen are drawn, however big the directory is.
+
+    for (y = 0; y < FILELIST_H; ++y)
+    {
+        i = list->top + y;
+
+        TXT_GotoXY(origin_x, origin_y + y);
+        TXT_RestoreColors(&colors);
+
+        if (i >= list->num_visible)
+        {
+            TXT_FillSpan(' ', w);
+            continue;
+        }
+
+        if (i == list->selected)
+        {
+            TXT_BGColor(list->widget.focused ? TXT_COLOR_GREY
+                                             : TXT_COLOR_BLACK, 0);
+        }
+
+        if (list->listing->entries[list->visible[i]].is_dir)
+        {
+            TXT_FGColor(TXT_COLOR_BRIGHT_CYAN);
+        }
+
+        DrawEntry(&list->listing->entries[list->visible[i]], w);
+    }
+
+    TXT_RestoreColors(&colors);
+
+    if (list->num_visible > FILELIST_H)
+    {
+        TXT_DrawVertScrollbar(origin_x + w, origin_y, FILELIST_H,
+                              list->selected, list->num_visible - 1);
+    }
+}
+
+static void TXT_FileListDestructor(TXT_UNCAST_ARG(list))
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+
+    CloseDirectory(list);
+
+    free(list->visible);
+    free(list->select_name);
+    free(list->path);
+}
+
+static int TXT_FileListKeyPress(TXT_UNCAST_ARG(list), int key)
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+    size_t len;
+
+    switch (key)
+    {
+        case KEY_UPARROW:
+            SetSelection(list, list->selected - 1);
+            return 1;
+
+        case KEY_DOWNARROW:
+            SetSelection(list, list->selected + 1);
+            return 1;
+
+        case KEY_PGUP:
+            SetSelection(list, list->selected - (FILELIST_H - 1));
+            return 1;
+
+        case KEY_PGDN:
+            SetSelection(list, list->selected + (FILELIST_H - 1));
+            return 1;
+
+        case KEY_HOME:
+            SetSelection(list, 0);
+            return 1;
+
+        case KEY_END:
+            SetSelection(list, list->num_visible - 1);
+            return 1;
+
+        case KEY_ENTER:
+            ActivateSelection(list);
+            return 1;
+
+        case KEY_BACKSPACE:
+            len = strlen(list->typeahead);
+
+            if (len > 0
+             && SDL_GetTicks() - list->typeahead_time < TYPEAHEAD_TIMEOUT)
+            {
+                list->typeahead[len - 1] = '\0';
+                list->typeahead_time = SDL_GetTicks();
+            }
+            else
+            {
+                GoToParent(list);
+            }
+            return 1;
+
+        default:
+            break;
+    }
+
+    if (key >= ' ' && key < 127 && isprint(key))
+    {
+        TypeAheadKey(list, key);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void TXT_FileListMousePress(TXT_UNCAST_ARG(list), int x, int y, int b)
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+    int i;
+
+    if (b == TXT_MOUSE_SCROLLUP)
+    {
+        ScrollList(list, -3);
+    }
+    else if (b == TXT_MOUSE_SCROLLDOWN)
+    {
+        ScrollList(list, 3);
+    }
+    else if (b == TXT_MOUSE_LEFT)
+    {
+        i = list->top + y - list->widget.y;
+
+        if (i >= list->num_visible)
+        {
+            return;
+        }
+
+        // Clicking on the selected entry opens it.
+
+        if (i == list->selected)
+        {
+            ActivateSelection(list);
+        }
+        else
+        {
+            SetSelection(list, i);
+        }
+    }
+}
+
+static txt_widget_class_t txt_filelist_class =
+{
+    TXT_AlwaysSelectable,
+    TXT_FileListSizeCalc,
+    TXT_FileListDrawer,
+    TXT_FileListKeyPress,
+    TXT_FileListDestructor,
+    TXT_FileListMousePress,
+    NULL,
+};
+
+// "Choose" action in directory mode: picks the highlighted directory, or
+// the current one if ".." is highlighted.
+
+static void ChooseDirectory(TXT_UNCAST_ARG(widget), TXT_UNCAST_ARG(list))
+{
+    TXT_CAST_ARG(txt_filelist_t, list);
+    txt_direntry_t *entry;
+
+    entry = SelectedEntry(list);
+
+    if (entry != NULL && strcmp(entry->name, ".."))
+    {
+        ChoosePath(list, JoinPath(list->path, entry->name));
+    }
+    else
+    {
+        ChoosePath(list, estrdup(list->path));
+    }
+}
+
+// Work out where to start browsing from. If start_path names a file,
+// browse its directory and select the file.
+
+static char *StartDirectory(const char *start_path, char **select_name)
+{
+    char *cwd, *path, *parent;
+
+    cwd = CurrentDirectory();
+
+    if (estrempty(start_path))
+    {
+        return cwd;
+    }
+
+    while (start_path[0] == '.' && IsSeparator(start_path[1]))
+    {
+        start_path += 2;
+    }
+
+    if (IsAbsolutePath(start_path))
+    {
+        path = estrdup(start_path);
+    }
+    else
+    {
+        path = JoinPath(cwd, start_path);
+    }
+
+    if (IsDirectory(path, NULL))
+    {
+        free(cwd);
+        return path;
+    }
+
+    parent = ParentPath(path);
+
+    if (parent != NULL && IsDirectory(parent, NULL))
+    {
+        *select_name = estrdup(BaseName(path));
+        free(path);
+        free(cwd);
+        return parent;
+    }
+
+    free(parent);
+    free(path);
+
+    return cwd;
+}
+
+txt_window_t *TXT_NewFileBrowser(const char *title, const char *start_path,
+                                 const char **extensions,
+                                 TxtFileBrowserCallback callback,
+                                 void *user_data)
+{
+    txt_window_t *window;
+    txt_filelist_t *list;
+    txt_window_action_t *choose;
+
+    if (scan_event_type == (Uint32) -1)
+    {
+        scan_event_type = SDL_RegisterEvents(1);
+    }
+
+    window = TXT_NewWindow(title);
+
+    list = calloc(1, sizeof(txt_filelist_t));
+    TXT_InitWidget(list, &txt_filelist_class);
+    list->window = window;
+    list->extensions = extensions;
+    list->callback = callback;
+    list->user_data = user_data;
+    list->path_label = TXT_NewLabel("");
+    list->status_label = TXT_NewLabel("");
+
+    TXT_AddWidgets(window,
+                   list->path_label,
+                   list,
+                   list->status_label,
+                   NULL);
+    TXT_SelectWidget(window, list);
+
+    if (extensions == TXT_DIRECTORY)
+    {
+        choose = TXT_NewWindowAction(KEY_F10, "Choose");
+        TXT_SignalConnect(choose, "pressed", ChooseDirectory, list);
+        TXT_SetWindowAction(window, TXT_HORIZ_CENTER, choose);
+    }
+
+    ChangeDirectory(list, StartDirectory(start_path, &list->select_name));
+
+    return window;
+}
@@ -0,0 +1,65 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Built-in directory browser window.
+//
+
+#ifndef TXT_FILEBROWSER_H
+#define TXT_FILEBROWSER_H
+
+/**
+ * @file txt_filebrowser.h
+ *
+ * Built-in file browser window.
+ */
+
+#include "txt_window.h"
+
+/**
+ * Callback function invoked when a file or directory is chosen in a
+ * file browser window. The path is only valid for the duration of the
+ * call.
+ */
+
+typedef void (*TxtFileBrowserCallback)(const char *path, void *user_data);
+
+/**
+ * Open a file browser window.
+ *
+ * Directories are read on a background thread, and entries are added to
+ * the list as they arrive, so the window is usable immediately even on
+ * slow media. Listings are cached per directory and reused for as long as
+ * the directory's modification time is unchanged.
+ *
+ * Typing while the list is selected jumps to the first entry beginning
+ * with the typed characters.
+ *
+ * @param title        Title of the window (UTF-8 format).
+ * @param start_path   File or directory to start browsing from, or NULL
+ *                     to start in the current directory.
+ * @param extensions   NULL-terminated list of filename extensions for
+ *                     files that can be selected, or @ref TXT_DIRECTORY
+ *                     to select directories.
+ * @param callback     Function to invoke with the chosen path. It is not
+ *                     invoked if the window is closed without a choice.
+ * @param user_data    User-specified pointer to pass to the callback.
+ * @return             The new window.
+ */
+
+txt_window_t *TXT_NewFileBrowser(const char *title, const char *start_path,
+                                 const char **extensions,
+                                 TxtFileBrowserCallback callback,
+                                 void *user_data);
+
+#endif /* #ifndef TXT_FILEBROWSER_H */
@@ -17,11 +17,13 @@
 
 #include "../elib/elib.h"
 #include "doomkeys.h"
+#include "txt_filebrowser.h"
 #include "txt_fileselect.h"
 #include "txt_inputbox.h"
 #include "txt_gui.h"
 #include "txt_io.h"
 #include "txt_main.h"
+#include "txt_process.h"
 #include "txt_widget.h"
 
 struct txt_fileselect_s {
@@ -36,102 +38,95 @@ struct txt_fileselect_s {
 
 const char *TXT_DIRECTORY[] = { "__directory__", NULL };
 
-#ifndef _WIN32
+#if defined(__MACOSX__)
 
-#include <fcntl.h>
-#include <unistd.h>
-#include <errno.h>
-#include <sys/wait.h>
+// Output collected from a helper program by ExecReadOutput.
 
-static char *ExecReadOutput(char **argv)
+typedef struct
 {
     char *result;
+    size_t result_len;
+    int status;
     int completed;
-    int pid, status, result_len;
-    int pipefd[2];
+} exec_output_t;
 
-    if (pipe(pipefd) != 0)
-    {
-        return NULL;
-    }
-
-    pid = fork();
+static void ExecOutputCallback(txt_process_t *process, const char *data,
+                               size_t len, void *user_data)
+{
+    exec_output_t *output = user_data;
+    char *new_result;
 
-    if (pid == 0)
+    new_result = realloc(output->result, output->result_len + len + 1);
+    if (new_result == NULL)
     {
-        dup2(pipefd[1], fileno(stdout));
-        execv(argv[0], argv);
-        exit(-1);
+        return;
     }
+    output->result = new_result;
+    memcpy(output->result + output->result_len, data, len);
+    output->result_len += len;
+    output->result[output->result_len] = '\0';
+}
 
-    fcntl(pipefd[0], F_SETFL, O_NONBLOCK);
+static void ExecExitCallback(txt_process_t *process, int exit_status,
+                             void *user_data)
+{
+    exec_output_t *output = user_data;
 
-    // Read program output into 'result' string.
-    // Wait until the program has completed and (if it was successful)
-    // a full line has been read.
+    output->status = exit_status;
+    output->completed = 1;
+}
 
-    result = NULL;
-    result_len = 0;
-    completed = 0;
+static char *ExecReadOutput(char **argv)
+{
+    exec_output_t output;
+
+    output.result = NULL;
+    output.result_len = 0;
+    output.status = -1;
+    output.completed = 0;
 
-    while (!completed
-        || (status == 0 && (result == NULL || strchr(result, '\n') == NULL)))
+    if (TXT_SpawnProcess((const char *const *) argv,
+                         TXT_PROCESS_CAPTURE_STDOUT, ExecOutputCallback,
+                         ExecExitCallback, &output) == NULL)
     {
-        char buf[64];
-        int bytes;
+        return NULL;
+    }
 
-        if (!completed && waitpid(pid, &status, WNOHANG) != 0)
-        {
-            completed = 1;
-        }
+    // The dialog is modal, so input is discarded until the program has
+    // completed. TXT_Sleep wakes up as soon as the program writes some
+    // output or exits, rather than polling.
 
-        bytes = read(pipefd[0], buf, sizeof(buf));
+    for (;;)
+    {
+        while (TXT_GetChar() >= 0);
 
-        if (bytes < 0)
-        {
-            if (errno != EAGAIN && errno != EWOULDBLOCK)
-            {
-                status = -1;
-                break;
-            }
-        }
-        else
+        TXT_PollProcesses();
+
+        if (output.completed)
         {
-            char *new_result = realloc(result, result_len + bytes + 1);
-            if (new_result == NULL)
-            {
-                break;
-            }
-            result = new_result;
-            memcpy(result + result_len, buf, bytes);
-            result_len += bytes;
-            result[result_len] = '\0';
+            break;
         }
 
-        usleep(100 * 1000);
-        TXT_Sleep(1);
         TXT_UpdateScreen();
+        TXT_Sleep(0);
     }
 
-    close(pipefd[0]);
-    close(pipefd[1]);
-
     // Must have a success exit code.
 
-    if (WEXITSTATUS(status) != 0)
+    if (output.status != 0)
     {
-        free(result);
-        result = NULL;
+        free(output.result);
+        output.result = NULL;
     }
 
     // Strip off newline from the end.
 
-    if (result != NULL && result[result_len - 1] == '\n')
+    if (output.result != NULL && output.result[output.result_len - 1] == '\n')
     {
-        result[result_len - 1] = '\0';
+        output.result[output.result_len - 1] = '\0';
     }
 
-    return result;
+    return output.result;
 }
 
 #endif
@@ -144,19 +139,8 @@ static char *ExecReadOutput(char **argv)
 //     TXT_UpdateScreen can be run in the background).
 //   * On Windows XP the program exits/crashes when the dialog is
 //     closed.
-#if defined(_WIN32)
-
-int TXT_CanSelectFiles(void)
-{
-    return 0;
-}
-
-char *TXT_SelectFile(const char *window_title, const char **extensions)
-{
-    return NULL;
-}
-
-#elif defined(xxxdisabled_WIN32)
+// The built-in file browser (txt_filebrowser.c) is used instead.
+#if defined(xxxdisabled_WIN32)
 
 // Windows code. Use comdlg32 to pop up a dialog box.
 
@@ -544,135 +528,18 @@ char *TXT_SelectFile(const char *window_title, const char **extensions)
 
 #else
 
-// Linux version: invoke the Zenity command line program to pop up a
-// dialog box. This avoids adding Gtk+ as a compile dependency.
-
-#define ZENITY_BINARY "/usr/bin/zenity"
-
-static unsigned int NumExtensions(const char **extensions)
-{
-    unsigned int result = 0;
-
-    if (extensions != NULL)
-    {
-        for (result = 0; extensions[result] != NULL; ++result);
-    }
-
-    return result;
-}
-
-static int ZenityAvailable(void)
-{
-    return system(ZENITY_BINARY " --help >/dev/null 2>&1") == 0;
-}
+// No native file selector; DoSelectFile falls back to the built-in
+// file browser, which reads directories on a worker thread instead of
+// blocking on an external program such as zenity.
 
 int TXT_CanSelectFiles(void)
 {
-    return ZenityAvailable();
-}
-
-//
-// ExpandExtension
-// given an extension (like wad)
-// return a pointer to a string that is a case-insensitive
-// pattern representation (like [Ww][Aa][Dd])
-//
-static char *ExpandExtension(const char *orig)
-{
-    int oldlen, newlen, i;
-    char *c, *newext = NULL;
-
-    oldlen = strlen(orig);
-    newlen = oldlen * 4; // pathological case: 'w' => '[Ww]'
-    newext = malloc(newlen+1);
-
-    if (newext == NULL)
-    {
-        return NULL;
-    }
-
-    c = newext;
-    for (i = 0; i < oldlen; ++i)
-    {
-        if (isalpha(orig[i]))
-        {
-            *c++ = '[';
-            *c++ = tolower(orig[i]);
-            *c++ = toupper(orig[i]);
-            *c++ = ']';
-        }
-        else
-        {
-            *c++ = orig[i];
-        }
-    }
-    *c = '\0';
-    return newext;
+    return 0;
 }
 
 char *TXT_SelectFile(const char *window_title, const char **extensions)
 {
-    unsigned int i;
-    size_t len;
-    char *result;
-    char **argv;
-    int argc;
-
-    if (!ZenityAvailable())
-    {
-        return NULL;
-    }
-
-    argv = calloc(5 + NumExtensions(extensions), sizeof(char *));
-    argv[0] = estrdup(ZENITY_BINARY);
-    argv[1] = estrdup("--file-selection");
-    argc = 2;
-
-    if (window_title != NULL)
-    {
-        len = 10 + strlen(window_title);
-        argv[argc] = malloc(len);
-        TXT_snprintf(argv[argc], len, "--title=%s", window_title);
-        ++argc;
-    }
-
-    if (extensions == TXT_DIRECTORY)
-    {
-        argv[argc] = estrdup("--directory");
-        ++argc;
-    }
-    else if (extensions != NULL)
-    {
-        for (i = 0; extensions[i] != NULL; ++i)
-        {
-            char * newext = ExpandExtension(extensions[i]);
-            if (newext)
-            {
-                len = 30 + strlen(extensions[i]) + strlen(newext);
-                argv[argc] = malloc(len);
-                TXT_snprintf(argv[argc], len, "--file-filter=.%s | *.%s",
-                             extensions[i], newext);
-                ++argc;
-                free(newext);
-            }
-        }
-
-        argv[argc] = estrdup("--file-filter=*.* | *.*");
-        ++argc;
-    }
-
-    argv[argc] = NULL;
-
-    result = ExecReadOutput(argv);
-
-    for (i = 0; i < argc; ++i)
-    {
-        free(argv[i]);
-    }
-
-    free(argv);
-
-    return result;
+    return NULL;
 }
 
 #endif
@@ -714,6 +581,20 @@ static void TXT_FileSelectDestructor(TXT_UNCAST_ARG(fileselect))
     TXT_DestroyWidget(fileselect->inputbox);
 }
 
+// Called when a path is chosen in the built-in file browser.
+
+static void FileBrowserCallback(const char *path, void *user_data)
+{
+    txt_fileselect_t *fileselect = user_data;
+    char **var;
+
+    var = fileselect->inputbox->value;
+    free(*var);
+    *var = estrdup(path);
+
+    TXT_EmitSignal(&fileselect->widget, "changed");
+}
+
 static int DoSelectFile(txt_fileselect_t *fileselect)
 {
     char *path;
@@ -739,7 +620,14 @@ static int DoSelectFile(txt_fileselect_t *fileselect)
         return 1;
     }
 
-    return 0;
+    // Otherwise use the built-in browser. It runs asynchronously, so the
+    // value is updated by FileBrowserCallback if a file is chosen.
+
+    var = fileselect->inputbox->value;
+    TXT_NewFileBrowser(fileselect->prompt, *var, fileselect->extensions,
+                       FileBrowserCallback, fileselect);
+
+    return 1;
 }
 
 static int TXT_FileSelectKeyPress(TXT_UNCAST_ARG(fileselect), int key)
@@ -12,6 +12,8 @@
 // GNU General Public License for more details.
 //
 
+#include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -20,14 +22,16 @@
 #include "txt_main.h"
 #include "txt_utf8.h"
 
-typedef struct txt_cliparea_s txt_cliparea_t;
-
-struct txt_cliparea_s
+typedef struct
 {
     int x1, x2;
     int y1, y2;
-    txt_cliparea_t *next;
-};
+} txt_cliparea_t;
+
+// Deepest that clip areas can be nested. Areas pushed beyond this are
+// ignored, and drawing stays clipped to the last one that fitted.
+
+#define MAX_CLIP_DEPTH 32
 
 // Array of border characters for drawing windows. The array looks like this:
 //
@@ -44,116 +48,201 @@ static const int borders[4][4] =
     {0xc0, 0xc4, 0xc1, 0xd9},
 };
 
-static txt_cliparea_t *cliparea = NULL;
+// Stack of clip areas; the first is the whole screen, and is never popped.
+
+static txt_cliparea_t clip_stack[MAX_CLIP_DEPTH] =
+{
+    { 0, TXT_SCREEN_W, 0, TXT_SCREEN_H },
+};
+static int clip_depth = 0;
+static int clip_overflow = 0;
+static txt_cliparea_t *cliparea = &clip_stack[0];
 
 #define VALID_X(x) ((x) >= cliparea->x1 && (x) < cliparea->x2)
 #define VALID_Y(y) ((y) >= cliparea->y1 && (y) < cliparea->y2)
 
-void TXT_DrawDesktopBackground(const char *title)
+// Get the attribute byte for the current colors.
+static int CurrentAttribute(void)
 {
-    int i;
-    unsigned char *screendata;
-    unsigned char *p;
+    txt_saved_colors_t colors;
+
+    TXT_SaveColors(&colors);
+
+    return colors.fgcolor | (colors.bgcolor << 4);
+}
+
+// Combine a character and attribute into a screen cell, as the two are
+// laid out in memory, so that cells can be written 16 bits at a time.
+static uint16_t MakeCell(int c, int attr)
+{
+    unsigned char bytes[2];
+    uint16_t cell;
+
+    bytes[0] = (unsigned char) c;
+    bytes[1] = (unsigned char) attr;
+    memcpy(&cell, bytes, sizeof(cell));
 
-    screendata = TXT_GetScreenData();
-    
-    // Fill the screen with gradient characters
+    return cell;
+}
 
-    p = screendata;
-    
-    for (i=0; i<TXT_SCREEN_W * TXT_SCREEN_H; ++i)
+// Clip a rectangle against the clip area. Returns zero if nothing of it
+// is left to draw.
+static int ClipRect(int *x, int *y, int *w, int *h)
+{
+    int x2 = *x + *w;
+    int y2 = *y + *h;
+
+    if (*x < cliparea->x1)
+        *x = cliparea->x1;
+    if (*y < cliparea->y1)
+        *y = cliparea->y1;
+    if (x2 > cliparea->x2)
+        x2 = cliparea->x2;
+    if (y2 > cliparea->y2)
+        y2 = cliparea->y2;
+
+    *w = x2 - *x;
+    *h = y2 - *y;
+
+    return *w > 0 && *h > 0;
+}
+
+// Fill a rectangle with a character in the current colors.
+void TXT_FillRect(int x, int y, int w, int h, int c)
+{
+    uint16_t *row;
+    uint16_t cell;
+    int x1, y1;
+
+    if (!ClipRect(&x, &y, &w, &h))
     {
-        *p++ = 0xb1;
-        *p++ = TXT_COLOR_GREY | (TXT_COLOR_BLUE << 4);
+        return;
     }
 
-    // Draw the top and bottom banners
+    cell = MakeCell(c, CurrentAttribute());
+    row = (uint16_t *) TXT_GetScreenData() + y * TXT_SCREEN_W + x;
 
-    p = screendata;
+    for (y1 = 0; y1 < h; ++y1)
+    {
+        for (x1 = 0; x1 < w; ++x1)
+        {
+            row[x1] = cell;
+        }
+
+        row += TXT_SCREEN_W;
+    }
+}
+
+// Draw a character w times from the cursor position, and move the cursor
+// past them, as TXT_DrawString() would.
+void TXT_FillSpan(int c, int w)
+{
+    int x, y;
 
-    for (i=0; i<TXT_SCREEN_W; ++i)
+    if (w <= 0)
     {
-        *p++ = ' ';
-        *p++ = TXT_COLOR_BLACK | (TXT_COLOR_GREY << 4);
+        return;
     }
 
-    p = screendata + (TXT_SCREEN_H - 1) * TXT_SCREEN_W * 2;
+    TXT_GetXY(&x, &y);
+    TXT_FillRect(x, y, w, 1, c);
+    TXT_GotoXY(x + w, y);
+}
 
-    for (i=0; i<TXT_SCREEN_W; ++i)
+// Set the attribute of each cell in a rectangle, keeping the characters.
+void TXT_FillAttributes(int x, int y, int w, int h, int attr)
+{
+    unsigned char *row;
+    int x1, y1;
+
+    if (!ClipRect(&x, &y, &w, &h))
     {
-        *p++ = ' ';
-        *p++ = TXT_COLOR_BLACK | (TXT_COLOR_GREY << 4);
+        return;
     }
 
-    // Print the title
+    row = TXT_GetScreenData() + (y * TXT_SCREEN_W + x) * 2;
 
-    TXT_GotoXY(0, 0);
-    TXT_FGColor(TXT_COLOR_BLACK);
-    TXT_BGColor(TXT_COLOR_GREY, 0);
+    for (y1 = 0; y1 < h; ++y1)
+    {
+        for (x1 = 0; x1 < w; ++x1)
+        {
+            row[x1 * 2 + 1] = attr;
+        }
 
-    TXT_DrawString(" ");
-    TXT_DrawString(title);
+        row += TXT_SCREEN_W * 2;
+    }
 }
 
-void TXT_DrawShadow(int x, int y, int w, int h)
+// Copy a run of code page characters to (x, y) in the current colors,
+// clipping it against the clip area as a whole.
+static void CopySpan(const char *s, int x, int y, int len)
 {
-    unsigned char *screendata;
     unsigned char *p;
-    int x1, y1;
+    unsigned char attr;
+    int x1 = x, h = 1;
+    int i;
+
+    if (!ClipRect(&x1, &y, &len, &h))
+    {
+        return;
+    }
 
-    screendata = TXT_GetScreenData();
+    s += x1 - x;
+    p = TXT_GetScreenData() + (y * TXT_SCREEN_W + x1) * 2;
+    attr = CurrentAttribute();
 
-    for (y1=y; y1<y+h; ++y1)
+    for (i = 0; i < len; ++i)
     {
-        p = screendata + (y1 * TXT_SCREEN_W + x) * 2;
+        p[i * 2] = s[i];
+        p[i * 2 + 1] = attr;
+    }
+}
 
-        for (x1=x; x1<x+w; ++x1)
-        {
-            if (VALID_X(x1) && VALID_Y(y1))
-            {
-                p[1] = TXT_COLOR_DARK_GREY;
-            }
+void TXT_DrawShadow(int x, int y, int w, int h)
+{
+    TXT_FillAttributes(x, y, w, h, TXT_COLOR_DARK_GREY);
+}
 
-            p += 2;
-        }
+// Draw one row of a window frame, from a row of the borders array.
+static void DrawFrameRow(int x, int y, int w, const int *border)
+{
+    if (w > 1)
+    {
+        TXT_FillRect(x + w - 1, y, 1, 1, border[3]);
     }
+
+    TXT_FillRect(x + 1, y, w - 2, 1, border[1]);
+    TXT_FillRect(x, y, 1, 1, border[0]);
 }
 
 void TXT_DrawWindowFrame(const char *title, int x, int y, int w, int h)
 {
     txt_saved_colors_t colors;
-    int x1, y1;
-    int bx, by;
 
     TXT_SaveColors(&colors);
     TXT_FGColor(TXT_COLOR_BRIGHT_CYAN);
 
-    for (y1=y; y1<y+h; ++y1)
+    // Draw the sides and clear the inside, then the rows that are
+    // different on top: the bottom, the horizontal line on the third line
+    // down that boxes in the title, and the top, which take precedence in
+    // that order where they overlap.
+
+    TXT_FillRect(x, y, 1, h, borders[1][0]);
+    TXT_FillRect(x + 1, y, w - 2, h, borders[1][1]);
+    TXT_FillRect(x + w - 1, y, 1, h, borders[1][3]);
+
+    if (h > 1)
     {
-        // Select the appropriate row and column in the borders
-        // array to pick the appropriate character to draw at
-        // this location.
-        //
-        // Draw a horizontal line on the third line down, so we
-        // draw a box around the title.
-
-        by = y1 == y ? 0 :
-             y1 == y + 2 && title != NULL ? 2 :
-             y1 == y + h - 1 ? 3 : 1;
-
-        for (x1=x; x1<x+w; ++x1)
-        {
-            bx = x1 == x ? 0 :
-                 x1 == x + w - 1 ? 3 : 1;
-                 
-            if (VALID_X(x1) && VALID_Y(y1))
-            {
-                TXT_GotoXY(x1, y1);
-                TXT_PutChar(borders[by][bx]);
-            }
-        }
+        DrawFrameRow(x, y + h - 1, w, borders[3]);
     }
 
+    if (title != NULL && h > 2)
+    {
+        DrawFrameRow(x, y + 2, w, borders[2]);
+    }
+
+    DrawFrameRow(x, y, w, borders[0]);
+
     // Draw the title
 
     if (title != NULL)
@@ -162,11 +251,8 @@ void TXT_DrawWindowFrame(const char *title, int x, int y, int w, int h)
         TXT_BGColor(TXT_COLOR_GREY, 0);
         TXT_FGColor(TXT_COLOR_BLUE);
 
-        for (x1=0; x1<w-2; ++x1)
-        {
-            TXT_DrawString(" ");
-        }
-    
+        TXT_FillSpan(' ', w - 2);
+
         TXT_GotoXY(x + (w - TXT_UTF8_Strlen(title)) / 2, y + 1);
         TXT_DrawString(title);
     }
@@ -183,25 +269,24 @@ void TXT_DrawSeparator(int x, int y, int w)
 {
     txt_saved_colors_t colors;
     unsigned char *data;
+    int attr;
     int x1;
     int b;
 
-    data = TXT_GetScreenData();
-
-    TXT_SaveColors(&colors);
-    TXT_FGColor(TXT_COLOR_BRIGHT_CYAN);
-
     if (!VALID_Y(y))
     {
         return;
     }
 
-    data += (y * TXT_SCREEN_W + x) * 2;
+    data = TXT_GetScreenData() + (y * TXT_SCREEN_W + x) * 2;
+
+    TXT_SaveColors(&colors);
+    TXT_FGColor(TXT_COLOR_BRIGHT_CYAN);
+    attr = CurrentAttribute();
+    TXT_RestoreColors(&colors);
 
     for (x1=x; x1<x+w; ++x1)
     {
-        TXT_GotoXY(x1, y);
-
         b = x1 == x ? 0 :
             x1 == x + w - 1 ? 3 :
             1;
@@ -214,14 +299,29 @@ void TXT_DrawSeparator(int x, int y, int w)
 
             if (*data == borders[1][b])
             {
-                TXT_PutChar(borders[2][b]);
+                data[0] = borders[2][b];
+                data[1] = attr;
             }
         }
 
         data += 2;
     }
 
-    TXT_RestoreColors(&colors);
+    TXT_GotoXY(x + w, y);
+}
+
+// Get the length of the run of printable ASCII characters at the start
+// of a string. These are the same in the code page as in Unicode.
+static int ASCIIRunLength(const char *s)
+{
+    const unsigned char *p = (const unsigned char *) s;
+
+    while (*p >= 0x20 && *p < 0x7f)
+    {
+        ++p;
+    }
+
+    return (int) (p - (const unsigned char *) s);
 }
 
 // Alternative to TXT_DrawString() where the argument is a "code page
@@ -231,6 +331,7 @@ void TXT_DrawCodePageString(const char *s)
     int x, y;
     int x1;
     const char *p;
+    int run;
 
     TXT_GetXY(&x, &y);
 
@@ -238,14 +339,26 @@ void TXT_DrawCodePageString(const char *s)
     {
         x1 = x;
 
-        for (p = s; *p != '\0'; ++p)
+        for (p = s; *p != '\0'; )
         {
+            // Everything but control characters is drawn as it is.
+            run = (int) strcspn(p, "\n\b");
+
+            if (run > 0)
+            {
+                CopySpan(p, x1, y, run);
+                p += run;
+                x1 += run;
+                continue;
+            }
+
             if (VALID_X(x1))
             {
                 TXT_GotoXY(x1, y);
                 TXT_PutChar(*p);
             }
 
+            ++p;
             x1 += 1;
         }
     }
@@ -286,6 +399,7 @@ void TXT_DrawString(const char *s)
     int x1;
     const char *p;
     unsigned int c;
+    int run;
 
     TXT_GetXY(&x, &y);
 
@@ -295,6 +409,17 @@ void TXT_DrawString(const char *s)
 
         for (p = s; *p != '\0'; )
         {
+            // Runs of plain ASCII need no decoding or mapping.
+            run = ASCIIRunLength(p);
+
+            if (run > 0)
+            {
+                CopySpan(p, x1, y, run);
+                p += run;
+                x1 += run;
+                continue;
+            }
+
             c = TXT_DecodeUTF8(&p);
 
             if (c == 0)
@@ -318,7 +443,6 @@ void TXT_DrawString(const char *s)
 void TXT_DrawHorizScrollbar(int x, int y, int w, int cursor, int range)
 {
     txt_saved_colors_t colors;
-    int x1;
     int cursor_x;
 
     if (!VALID_Y(y))
@@ -330,8 +454,7 @@ void TXT_DrawHorizScrollbar(int x, int y, int w, int cursor, int range)
     TXT_FGColor(TXT_COLOR_BLACK);
     TXT_BGColor(TXT_COLOR_GREY, 0);
 
-    TXT_GotoXY(x, y);
-    TXT_PutChar('\x1b');
+    TXT_FillRect(x, y, 1, 1, 0x1b);
 
     cursor_x = x + 1;
 
@@ -345,29 +468,20 @@ void TXT_DrawHorizScrollbar(int x, int y, int w, int cursor, int range)
         cursor_x = x + w - 2;
     }
 
-    for (x1=x+1; x1<x+w-1; ++x1)
+    if (w > 2)
     {
-        if (VALID_X(x1))
-        {
-            if (x1 == cursor_x)
-            {
-                TXT_PutChar('\xdb');
-            }
-            else
-            {
-                TXT_PutChar('\xb1');
-            }
-        }
+        TXT_FillRect(x + 1, y, w - 2, 1, 0xb1);
+        TXT_FillRect(cursor_x, y, 1, 1, 0xdb);
     }
 
-    TXT_PutChar('\x1a');
+    TXT_FillRect(x + w - 1, y, 1, 1, 0x1a);
+    TXT_GotoXY(x + w, y);
     TXT_RestoreColors(&colors);
 }
 
 void TXT_DrawVertScrollbar(int x, int y, int h, int cursor, int range)
 {
     txt_saved_colors_t colors;
-    int y1;
     int cursor_y;
 
     if (!VALID_X(x))
@@ -379,8 +493,7 @@ void TXT_DrawVertScrollbar(int x, int y, int h, int cursor, int range)
     TXT_FGColor(TXT_COLOR_BLACK);
     TXT_BGColor(TXT_COLOR_GREY, 0);
 
-    TXT_GotoXY(x, y);
-    TXT_PutChar('\x18');
+    TXT_FillRect(x, y, 1, 1, 0x18);
 
     cursor_y = y + 1;
 
@@ -394,87 +507,78 @@ void TXT_DrawVertScrollbar(int x, int y, int h, int cursor, int range)
         cursor_y += (cursor * (h - 3)) / range;
     }
 
-    for (y1=y+1; y1<y+h-1; ++y1)
+    if (h > 2)
     {
-        if (VALID_Y(y1))
-        {
-            TXT_GotoXY(x, y1);
-
-            if (y1 == cursor_y)
-            {
-                TXT_PutChar('\xdb');
-            }
-            else
-            {
-                TXT_PutChar('\xb1');
-            }
-        }
+        TXT_FillRect(x, y + 1, 1, h - 2, 0xb1);
+        TXT_FillRect(x, cursor_y, 1, 1, 0xdb);
     }
 
-    TXT_GotoXY(x, y + h - 1);
-    TXT_PutChar('\x19');
+    TXT_FillRect(x, y + h - 1, 1, 1, 0x19);
+    TXT_GotoXY(x + 1, y + h - 1);
     TXT_RestoreColors(&colors);
 }
 
 void TXT_InitClipArea(void)
 {
-    if (cliparea == NULL)
-    {
-        cliparea = malloc(sizeof(txt_cliparea_t));
-        cliparea->x1 = 0;
-        cliparea->x2 = TXT_SCREEN_W;
-        cliparea->y1 = 0;
-        cliparea->y2 = TXT_SCREEN_H;
-        cliparea->next = NULL;
-    }
+    // Every area pushed while drawing the last frame should have been
+    // popped again.
+
+    assert(clip_depth == 0 && clip_overflow == 0);
+
+    clip_depth = 0;
+    clip_overflow = 0;
+    cliparea = &clip_stack[0];
 }
 
 void TXT_PushClipArea(int x1, int x2, int y1, int y2)
 {
-    txt_cliparea_t *newarea;
+    assert(clip_depth < MAX_CLIP_DEPTH - 1);
 
-    newarea = malloc(sizeof(txt_cliparea_t));
+    if (clip_overflow > 0 || clip_depth >= MAX_CLIP_DEPTH - 1)
+    {
+        ++clip_overflow;
+        return;
+    }
 
     // Set the new clip area to the intersection of the old
     // area and the new one.
 
-    newarea->x1 = cliparea->x1;
-    newarea->x2 = cliparea->x2;
-    newarea->y1 = cliparea->y1;
-    newarea->y2 = cliparea->y2;
-
-    if (x1 > newarea->x1)
-        newarea->x1 = x1;
-    if (x2 < newarea->x2)
-        newarea->x2 = x2;
-    if (y1 > newarea->y1)
-        newarea->y1 = y1;
-    if (y2 < newarea->y2)
-        newarea->y2 = y2;
+    if (x1 < cliparea->x1)
+        x1 = cliparea->x1;
+    if (x2 > cliparea->x2)
+        x2 = cliparea->x2;
+    if (y1 < cliparea->y1)
+        y1 = cliparea->y1;
+    if (y2 > cliparea->y2)
+        y2 = cliparea->y2;
 
 #if 0
     printf("New scrollable area: %i,%i-%i,%i\n", x1, y1, x2, y2);
 #endif
 
-    // Hook into the list
-
-    newarea->next = cliparea;
-    cliparea = newarea;
+    ++clip_depth;
+    cliparea = &clip_stack[clip_depth];
+    cliparea->x1 = x1;
+    cliparea->x2 = x2;
+    cliparea->y1 = y1;
+    cliparea->y2 = y2;
 }
 
 void TXT_PopClipArea(void)
 {
-    txt_cliparea_t *next_cliparea;
+    if (clip_overflow > 0)
+    {
+        --clip_overflow;
+        return;
+    }
 
     // Never pop the last entry
 
-    if (cliparea->next == NULL)
+    assert(clip_depth > 0);
+
+    if (clip_depth == 0)
         return;
 
-    // Unlink the last entry and delete
-   
-    next_cliparea = cliparea->next;
-    free(cliparea);
-    cliparea = next_cliparea;
+    --clip_depth;
+    cliparea = &clip_stack[clip_depth];
 }
-
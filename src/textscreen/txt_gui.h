@@ -22,11 +22,13 @@
 #define TXT_ACTIVE_WINDOW_BACKGROUND     TXT_COLOR_BLUE
 #define TXT_HOVER_BACKGROUND             TXT_COLOR_CYAN
 
-void TXT_DrawDesktopBackground(const char *title);
 void TXT_DrawWindowFrame(const char *title, int x, int y, int w, int h);
 void TXT_DrawSeparator(int x, int y, int w);
 void TXT_DrawCodePageString(const char *s);
 void TXT_DrawString(const char *s);
+void TXT_FillSpan(int c, int w);
+void TXT_FillRect(int x, int y, int w, int h, int c);
+void TXT_FillAttributes(int x, int y, int w, int h, int attr);
 int TXT_CanDrawCharacter(unsigned int c);
 
 void TXT_DrawHorizScrollbar(int x, int y, int w, int cursor, int range);
@@ -0,0 +1,244 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Index of where the widgets of a window are on the screen.
+//
+// The widgets are recorded as they are laid out, parents before the
+// widgets inside them. Each row of the screen then gets a list of the
+// spans of it that widgets cover, in the same order, so that the
+// innermost widget at a position is the last span in its row that
+// contains it.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "txt_hittest.h"
+#include "txt_main.h"
+#include "txt_perf.h"
+
+typedef struct
+{
+    int x1, y1, x2, y2;
+    txt_widget_t *widget;
+} txt_hit_rect_t;
+
+typedef struct
+{
+    short x1, x2;
+    txt_widget_t *widget;
+} txt_hit_span_t;
+
+struct txt_hit_index_s
+{
+    // Widgets recorded while laying out, and as of the last time the
+    // spans were built; if they are the same, the spans are still good.
+
+    txt_hit_rect_t *rects, *built_rects;
+    int num_rects, num_built_rects;
+    int rects_size;
+
+    txt_hit_span_t *spans;
+    int spans_size;
+
+    // Spans of row y are spans[row_start[y]] to spans[row_start[y + 1] - 1].
+
+    int row_start[TXT_SCREEN_H + 1];
+};
+
+static txt_hit_index_t *building = NULL;
+static txt_widget_t *building_root;
+
+void TXT_BeginHitIndex(txt_hit_index_t **index, txt_widget_t *root)
+{
+    if (*index == NULL)
+    {
+        *index = calloc(1, sizeof(txt_hit_index_t));
+        TXT_PerfCount(TXT_PERF_ALLOCS, 1);
+    }
+
+    building = *index;
+    building_root = root;
+    building->num_rects = 0;
+}
+
+void TXT_AddHitWidget(txt_widget_t *widget)
+{
+    txt_hit_rect_t r;
+    txt_widget_t *p;
+
+    if (building == NULL)
+    {
+        return;
+    }
+
+    r.x1 = widget->x;
+    r.y1 = widget->y;
+    r.x2 = widget->x + widget->w;
+    r.y2 = widget->y + widget->h;
+    r.widget = widget;
+
+    // A widget can only be clicked where the widgets it is inside are,
+    // which matters for the contents of scroll panes. The window's table
+    // is the exception, as the action area is outside it.
+
+    for (p = widget; p != NULL && p != building_root; p = p->parent)
+    {
+        if (!p->visible)
+        {
+            return;
+        }
+
+        if (r.x1 < p->x)
+            r.x1 = p->x;
+        if (r.y1 < p->y)
+            r.y1 = p->y;
+        if (r.x2 > p->x + (int) p->w)
+            r.x2 = p->x + (int) p->w;
+        if (r.y2 > p->y + (int) p->h)
+            r.y2 = p->y + (int) p->h;
+    }
+
+    if (r.x1 < 0)
+        r.x1 = 0;
+    if (r.y1 < 0)
+        r.y1 = 0;
+    if (r.x2 > TXT_SCREEN_W)
+        r.x2 = TXT_SCREEN_W;
+    if (r.y2 > TXT_SCREEN_H)
+        r.y2 = TXT_SCREEN_H;
+
+    if (r.x1 >= r.x2 || r.y1 >= r.y2)
+    {
+        return;
+    }
+
+    if (building->num_rects == building->rects_size)
+    {
+        building->rects_size = building->rects_size == 0 ? 32
+                             : building->rects_size * 2;
+        building->rects = realloc(building->rects,
+            building->rects_size * sizeof(txt_hit_rect_t));
+        building->built_rects = realloc(building->built_rects,
+            building->rects_size * sizeof(txt_hit_rect_t));
+        TXT_PerfCount(TXT_PERF_ALLOCS, 2);
+    }
+
+    building->rects[building->num_rects++] = r;
+}
+
+static void BuildSpans(txt_hit_index_t *index)
+{
+    int fill[TXT_SCREEN_H];
+    int num_spans;
+    int i, y;
+
+    // Count the spans in each row, then place them.
+
+    memset(index->row_start, 0, sizeof(index->row_start));
+
+    for (i = 0; i < index->num_rects; ++i)
+    {
+        for (y = index->rects[i].y1; y < index->rects[i].y2; ++y)
+        {
+            ++index->row_start[y + 1];
+        }
+    }
+
+    for (y = 0; y < TXT_SCREEN_H; ++y)
+    {
+        fill[y] = index->row_start[y];
+        index->row_start[y + 1] += index->row_start[y];
+    }
+
+    num_spans = index->row_start[TXT_SCREEN_H];
+
+    if (num_spans > index->spans_size)
+    {
+        index->spans_size = num_spans;
+        index->spans = realloc(index->spans,
+                               num_spans * sizeof(txt_hit_span_t));
+        TXT_PerfCount(TXT_PERF_ALLOCS, 1);
+    }
+
+    for (i = 0; i < index->num_rects; ++i)
+    {
+        const txt_hit_rect_t *r = &index->rects[i];
+
+        for (y = r->y1; y < r->y2; ++y)
+        {
+            index->spans[fill[y]].x1 = r->x1;
+            index->spans[fill[y]].x2 = r->x2;
+            index->spans[fill[y]].widget = r->widget;
+            ++fill[y];
+        }
+    }
+
+    memcpy(index->built_rects, index->rects,
+           index->num_rects * sizeof(txt_hit_rect_t));
+    index->num_built_rects = index->num_rects;
+}
+
+void TXT_EndHitIndex(void)
+{
+    txt_hit_index_t *index = building;
+
+    if (index == NULL)
+    {
+        return;
+    }
+
+    building = NULL;
+
+    // Only rebuild the spans if the layout has changed.
+
+    if (index->num_rects != index->num_built_rects
+     || memcmp(index->rects, index->built_rects,
+               index->num_rects * sizeof(txt_hit_rect_t)) != 0)
+    {
+        BuildSpans(index);
+    }
+}
+
+txt_widget_t *TXT_HitTest(txt_hit_index_t *index, int x, int y)
+{
+    int i;
+
+    if (index == NULL || y < 0 || y >= TXT_SCREEN_H)
+    {
+        return NULL;
+    }
+
+    for (i = index->row_start[y + 1] - 1; i >= index->row_start[y]; --i)
+    {
+        if (x >= index->spans[i].x1 && x < index->spans[i].x2)
+        {
+            return index->spans[i].widget;
+        }
+    }
+
+    return NULL;
+}
+
+void TXT_FreeHitIndex(txt_hit_index_t *index)
+{
+    if (index != NULL)
+    {
+        free(index->rects);
+        free(index->built_rects);
+        free(index->spans);
+        free(index);
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Index of where the widgets of a window are on the screen, for finding
+// the widget under the mouse.
+//
+
+#ifndef TXT_HITTEST_H
+#define TXT_HITTEST_H
+
+#include "txt_widget.h"
+
+typedef struct txt_hit_index_s txt_hit_index_t;
+
+// Start building the index for a window as it is laid out. The index is
+// allocated the first time; root is the window's table.
+void TXT_BeginHitIndex(txt_hit_index_t **index, txt_widget_t *root);
+
+// Add a widget to the index being built, once its position is set. This
+// is called by TXT_LayoutWidget().
+void TXT_AddHitWidget(txt_widget_t *widget);
+
+// Finish building the index.
+void TXT_EndHitIndex(void);
+
+// Get the innermost widget at the given screen position, or NULL if
+// there is none.
+txt_widget_t *TXT_HitTest(txt_hit_index_t *index, int x, int y);
+
+void TXT_FreeHitIndex(txt_hit_index_t *index);
+
+#endif /* #ifndef TXT_HITTEST_H */
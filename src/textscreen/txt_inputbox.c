@@ -125,7 +125,6 @@ static void TXT_InputBoxDrawer(TXT_UNCAST_ARG(inputbox))
 {
     TXT_CAST_ARG(txt_inputbox_t, inputbox);
     int focused;
-    int i;
     int chars;
     int w;
 
@@ -174,10 +173,7 @@ static void TXT_InputBoxDrawer(TXT_UNCAST_ARG(inputbox))
         ++chars;
     }
 
-    for (i=chars; i < w; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', w - chars);
 }
 
 static void TXT_InputBoxDestructor(TXT_UNCAST_ARG(inputbox))
@@ -73,21 +73,18 @@ static void TXT_LabelDrawer(TXT_UNCAST_ARG(label))
 
         // Gap at the start
 
-        for (x=0; x<align_indent; ++x)
-        {
-            TXT_DrawString(" ");
-        }
+        TXT_FillSpan(' ', align_indent);
 
         // The string itself
 
         TXT_DrawString(label->lines[y]);
-        x += sw;
+        x = align_indent + sw;
 
         // Gap at the end
 
-        for (; x<w; ++x)
+        if (x < w)
         {
-            TXT_DrawString(" ");
+            TXT_FillSpan(' ', w - x);
         }
     }
 }
@@ -133,10 +133,39 @@ typedef enum
 
 #endif  // __GNUC__
 
+// Where the screen is drawn.
+typedef enum
+{
+    // In a window on the desktop.
+    TXT_BACKEND_WINDOW,
+
+    // Into memory only. Nothing is shown and there is no input; used for
+    // benchmarks and for comparing screens against known-good images.
+    TXT_BACKEND_OFFSCREEN,
+
+    // On the terminal on standard input and output, for use over a
+    // remote shell.
+    TXT_BACKEND_TERMINAL,
+} txt_backend_t;
+
+// Select where the screen is drawn. Takes effect at the next TXT_Init.
+void TXT_SetBackend(txt_backend_t backend);
+
+// Get where the screen is drawn.
+txt_backend_t TXT_GetBackend(void);
+
 // Initialize the screen
 // Returns 1 if successful, 0 if failed.
 int TXT_Init(void);
 
+// Write the screen as last drawn to a PPM image file.
+// Returns 1 if successful, 0 if failed.
+int TXT_SaveScreenImage(const char *filename);
+
+// Get a hash of the screen as last drawn, for comparing against a
+// known-good image.
+unsigned int TXT_HashScreenImage(void);
+
 // Shut down text mode emulation
 void TXT_Shutdown(void);
 
@@ -0,0 +1,139 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Performance counters and the heads-up display that shows them.
+//
+
+#include "SDL.h"
+
+#include <string.h>
+
+#include "txt_io.h"
+#include "txt_main.h"
+#include "txt_perf.h"
+
+// Number of frames the display averages over.
+
+#define PERF_WINDOW 32
+
+unsigned int txt_perf_counters[TXT_NUM_PERF_COUNTERS];
+
+static unsigned int perf_history[PERF_WINDOW][TXT_NUM_PERF_COUNTERS];
+static unsigned int perf_totals[TXT_NUM_PERF_COUNTERS];
+static int perf_next;
+static int perf_frames;
+static int perf_hud_visible = 0;
+
+unsigned int TXT_PerfTime(void)
+{
+    static Uint64 frequency;
+    Uint64 counter;
+
+    if (frequency == 0)
+    {
+        frequency = SDL_GetPerformanceFrequency();
+    }
+
+    counter = SDL_GetPerformanceCounter();
+
+    return (unsigned int) ((counter / frequency) * 1000000
+                         + (counter % frequency) * 1000000 / frequency);
+}
+
+void TXT_PerfEndFrame(void)
+{
+    unsigned int *slot;
+    int i;
+
+    // Nobody is looking, so there is nothing to keep.
+
+    if (!perf_hud_visible)
+    {
+        memset(txt_perf_counters, 0, sizeof(txt_perf_counters));
+        return;
+    }
+
+    slot = perf_history[perf_next];
+
+    for (i = 0; i < TXT_NUM_PERF_COUNTERS; ++i)
+    {
+        perf_totals[i] += txt_perf_counters[i] - slot[i];
+        slot[i] = txt_perf_counters[i];
+        txt_perf_counters[i] = 0;
+    }
+
+    perf_next = (perf_next + 1) % PERF_WINDOW;
+
+    if (perf_frames < PERF_WINDOW)
+    {
+        ++perf_frames;
+    }
+}
+
+void TXT_TogglePerfHUD(void)
+{
+    perf_hud_visible = !perf_hud_visible;
+
+    memset(perf_history, 0, sizeof(perf_history));
+    memset(perf_totals, 0, sizeof(perf_totals));
+    perf_next = 0;
+    perf_frames = 0;
+}
+
+// Format an average time in microseconds as milliseconds.
+
+static void FormatTime(char *buf, size_t buf_len, unsigned int total,
+                       unsigned int frames)
+{
+    unsigned int avg = total / frames;
+
+    TXT_snprintf(buf, buf_len, "%u.%02u", avg / 1000, (avg % 1000) / 10);
+}
+
+void TXT_DrawPerfHUD(void)
+{
+    char frame[16], layout[16], raster[16];
+    char buf[TXT_SCREEN_W];
+    unsigned int frames;
+    int x;
+
+    if (!perf_hud_visible)
+    {
+        return;
+    }
+
+    frames = perf_frames > 0 ? perf_frames : 1;
+
+    FormatTime(frame, sizeof(frame), perf_totals[TXT_PERF_FRAME], frames);
+    FormatTime(layout, sizeof(layout), perf_totals[TXT_PERF_LAYOUT], frames);
+    FormatTime(raster, sizeof(raster), perf_totals[TXT_PERF_RASTER], frames);
+
+    TXT_snprintf(buf, sizeof(buf),
+                 " frame %sms layout %s raster %s up %uK ev %u skip %u"
+                 " alloc %u cull %u/f ",
+                 frame, layout, raster,
+                 perf_totals[TXT_PERF_UPLOADED] / 1024,
+                 perf_totals[TXT_PERF_EVENTS], perf_totals[TXT_PERF_SKIPPED],
+                 perf_totals[TXT_PERF_ALLOCS],
+                 perf_totals[TXT_PERF_CULLED] / frames);
+
+    // Right-aligned, leaving room for the help indicator.
+
+    x = TXT_SCREEN_W - 9 - (int) strlen(buf);
+    TXT_GotoXY(x > 0 ? x : 0, 0);
+    TXT_FGColor(TXT_COLOR_BLACK);
+    TXT_BGColor(TXT_COLOR_CYAN, 0);
+    TXT_Puts(buf);
+}
@@ -0,0 +1,59 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Performance counters and the heads-up display that shows them.
+//
+
+#ifndef TXT_PERF_H
+#define TXT_PERF_H
+
+// Key that shows and hides the display.
+
+#define TXT_PERF_HUD_KEY KEY_F12
+
+typedef enum
+{
+    TXT_PERF_FRAME,           // microseconds spent in the main loop
+    TXT_PERF_LAYOUT,          // microseconds spent laying out and drawing
+    TXT_PERF_RASTER,          // microseconds spent rendering characters
+    TXT_PERF_UPLOADED,        // bytes uploaded to the screen texture
+    TXT_PERF_EVENTS,          // input events processed
+    TXT_PERF_SKIPPED,         // screen updates skipped as unchanged
+    TXT_PERF_ALLOCS,          // allocations made by layout and drawing
+    TXT_PERF_CULLED,          // cells not drawn as windows cover them
+    TXT_NUM_PERF_COUNTERS
+} txt_perf_counter_t;
+
+// Counts for the frame in progress.
+
+extern unsigned int txt_perf_counters[TXT_NUM_PERF_COUNTERS];
+
+#define TXT_PerfCount(counter, n) (txt_perf_counters[counter] += (n))
+
+// Current time in microseconds, for timing counters. Only differences
+// between two times are meaningful.
+unsigned int TXT_PerfTime(void);
+
+// Add the frame's counts to the rolling window shown by the display, and
+// start a new frame.
+void TXT_PerfEndFrame(void);
+
+// Show or hide the display.
+void TXT_TogglePerfHUD(void);
+
+// Draw the display at the right of the top banner, if it is shown.
+void TXT_DrawPerfHUD(void);
+
+#endif /* #ifndef TXT_PERF_H */
@@ -0,0 +1,978 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Asynchronous child processes. A background thread waits for output
+// and exit notifications and wakes the main loop with an SDL event;
+// callbacks are then run from the main loop by TXT_PollProcesses.
+//
+// Output passes from the background thread to the main loop through a
+// fixed-size ring buffer per process. There is exactly one reader and
+// one writer, so the ring needs no lock; when it is full, the writer
+// stops reading the pipe until the main loop has caught up.
+//
+
+#include "SDL.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+extern char **environ;
+#endif
+
+#include "../elib/elib.h"
+#include "txt_main.h"
+#include "txt_process.h"
+#include "txt_term.h"
+
+// Size of the output ring buffer; must be a power of two.
+
+#define OUTPUT_RING_SIZE 16384
+
+struct txt_process_s
+{
+    txt_process_t *next;
+
+    TxtProcessOutputFunc output_callback;
+    TxtProcessExitFunc exit_callback;
+    void *user_data;
+
+#ifdef _WIN32
+    HANDLE handle;
+    HANDLE output;
+#else
+    pid_t pid;
+    int output_fd;
+    int pidfd;
+#endif
+
+    // Time taken to start the process, in microseconds.
+
+    unsigned int spawn_time;
+
+    // Output ring buffer. ring_head is only advanced by the watcher,
+    // and ring_tail only by the main loop.
+
+    SDL_atomic_t ring_head;
+    SDL_atomic_t ring_tail;
+    char ring[OUTPUT_RING_SIZE];
+
+    // The following are protected by process_lock. Once 'finished' is
+    // set, the watcher no longer touches the process.
+
+    int exited;
+    int exit_status;
+    int finished;
+
+    // Only used by TXT_PollProcesses.
+
+    unsigned int poll_serial;
+};
+
+static SDL_mutex *process_lock;
+static txt_process_t *processes;
+static int num_processes;
+
+// SDL event used to wake up the main loop.
+
+static Uint32 process_event_type = (Uint32) -1;
+
+static void WakeMainLoop(void)
+{
+    SDL_Event ev;
+
+    SDL_zero(ev);
+    ev.type = process_event_type;
+    SDL_PushEvent(&ev);
+    TXT_Term_Wake();
+}
+
+// Get the number of bytes of output waiting in the ring.
+
+static unsigned int RingUsed(txt_process_t *process)
+{
+    return (unsigned int) SDL_AtomicGet(&process->ring_head)
+         - (unsigned int) SDL_AtomicGet(&process->ring_tail);
+}
+
+// Writer side: get the largest contiguous free area of the ring. The
+// length is zero if the ring is full.
+
+static char *RingWriteSpace(txt_process_t *process, size_t *len)
+{
+    unsigned int head, offset;
+
+    head = (unsigned int) SDL_AtomicGet(&process->ring_head);
+    offset = head & (OUTPUT_RING_SIZE - 1);
+
+    *len = OUTPUT_RING_SIZE - RingUsed(process);
+
+    if (*len > OUTPUT_RING_SIZE - offset)
+    {
+        *len = OUTPUT_RING_SIZE - offset;
+    }
+
+    return process->ring + offset;
+}
+
+static void RingCommitWrite(txt_process_t *process, size_t len)
+{
+    // The data must be visible before the new head is.
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&process->ring_head, (int) len);
+}
+
+// Reader side: get the largest contiguous filled area of the ring.
+
+static const char *RingReadSpace(txt_process_t *process, size_t *len)
+{
+    unsigned int tail, offset;
+
+    *len = RingUsed(process);
+    SDL_MemoryBarrierAcquire();
+
+    tail = (unsigned int) SDL_AtomicGet(&process->ring_tail);
+    offset = tail & (OUTPUT_RING_SIZE - 1);
+
+    if (*len > OUTPUT_RING_SIZE - offset)
+    {
+        *len = OUTPUT_RING_SIZE - offset;
+    }
+
+    return process->ring + offset;
+}
+
+static void RingCommitRead(txt_process_t *process, size_t len)
+{
+    // We must be done with the data before the writer may reuse it.
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&process->ring_tail, (int) len);
+}
+
+// Get the time in microseconds since the given performance counter
+// value.
+
+static unsigned int MicrosecondsSince(Uint64 start)
+{
+    return (unsigned int) ((SDL_GetPerformanceCounter() - start) * 1000000
+                         / SDL_GetPerformanceFrequency());
+}
+
+static void InitProcesses(void)
+{
+    if (process_lock == NULL)
+    {
+        process_lock = SDL_CreateMutex();
+        process_event_type = SDL_RegisterEvents(1);
+    }
+}
+
+static txt_process_t *NewProcess(TxtProcessOutputFunc output_callback,
+                                 TxtProcessExitFunc exit_callback,
+                                 void *user_data)
+{
+    txt_process_t *process;
+
+    process = calloc(1, sizeof(txt_process_t));
+    process->output_callback = output_callback;
+    process->exit_callback = exit_callback;
+    process->user_data = user_data;
+
+    return process;
+}
+
+#ifdef _WIN32
+
+// Windows: each process gets a thread that reads its output pipe until
+// it is closed, then waits for the process to exit.
+
+static int ProcessThread(void *data)
+{
+    txt_process_t *process = data;
+    DWORD bytes, exit_code;
+    char *space;
+    size_t len;
+
+    if (process->output != NULL)
+    {
+        for (;;)
+        {
+            space = RingWriteSpace(process, &len);
+
+            if (len == 0)
+            {
+                // Wait for the main loop to make room.
+
+                SDL_Delay(1);
+                continue;
+            }
+
+            if (!ReadFile(process->output, space, (DWORD) len, &bytes, NULL)
+             || bytes == 0)
+            {
+                break;
+            }
+
+            RingCommitWrite(process, bytes);
+            WakeMainLoop();
+        }
+
+        CloseHandle(process->output);
+    }
+
+    WaitForSingleObject(process->handle, INFINITE);
+
+    if (!GetExitCodeProcess(process->handle, &exit_code))
+    {
+        exit_code = (DWORD) -1;
+    }
+
+    CloseHandle(process->handle);
+
+    SDL_LockMutex(process_lock);
+    process->exited = 1;
+    process->exit_status = (int) exit_code;
+    process->finished = 1;
+    SDL_UnlockMutex(process_lock);
+
+    WakeMainLoop();
+
+    return 0;
+}
+
+// Build the command line: the quoted program path followed by the
+// arguments as they are.
+
+static wchar_t *BuildCommandLine(const char *const *argv)
+{
+    char *cmdline;
+    wchar_t *result;
+    size_t len;
+    int i, wlen;
+
+    len = strlen(argv[0]) + 3;
+
+    for (i = 1; argv[i] != NULL; ++i)
+    {
+        len += strlen(argv[i]) + 1;
+    }
+
+    cmdline = malloc(len);
+    TXT_snprintf(cmdline, len, "\"%s\"", argv[0]);
+
+    for (i = 1; argv[i] != NULL; ++i)
+    {
+        TXT_StringConcat(cmdline, " ", len);
+        TXT_StringConcat(cmdline, argv[i], len);
+    }
+
+    wlen = MultiByteToWideChar(CP_UTF8, 0, cmdline, -1, NULL, 0);
+    result = calloc(wlen + 1, sizeof(wchar_t));
+    MultiByteToWideChar(CP_UTF8, 0, cmdline, -1, result, wlen);
+    free(cmdline);
+
+    return result;
+}
+
+txt_process_t *TXT_SpawnProcess(const char *const *argv, int capture,
+                                TxtProcessOutputFunc output_callback,
+                                TxtProcessExitFunc exit_callback,
+                                void *user_data)
+{
+    SECURITY_ATTRIBUTES sa;
+    STARTUPINFOW startup_info;
+    PROCESS_INFORMATION proc_info;
+    HANDLE read_pipe = NULL, write_pipe = NULL;
+    txt_process_t *process;
+    SDL_Thread *thread;
+    wchar_t *cmdline;
+    Uint64 start;
+    BOOL ok;
+
+    InitProcesses();
+
+    memset(&startup_info, 0, sizeof(startup_info));
+    startup_info.cb = sizeof(startup_info);
+
+    if (capture != 0)
+    {
+        sa.nLength = sizeof(sa);
+        sa.lpSecurityDescriptor = NULL;
+        sa.bInheritHandle = TRUE;
+
+        if (!CreatePipe(&read_pipe, &write_pipe, &sa, 0))
+        {
+            return NULL;
+        }
+
+        // Only the write end goes to the child.
+
+        SetHandleInformation(read_pipe, HANDLE_FLAG_INHERIT, 0);
+
+        startup_info.dwFlags = STARTF_USESTDHANDLES;
+        startup_info.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startup_info.hStdOutput = (capture & TXT_PROCESS_CAPTURE_STDOUT)
+                                ? write_pipe : GetStdHandle(STD_OUTPUT_HANDLE);
+        startup_info.hStdError = (capture & TXT_PROCESS_CAPTURE_STDERR)
+                               ? write_pipe : GetStdHandle(STD_ERROR_HANDLE);
+    }
+
+    cmdline = BuildCommandLine(argv);
+    memset(&proc_info, 0, sizeof(proc_info));
+
+    start = SDL_GetPerformanceCounter();
+    ok = CreateProcessW(NULL, cmdline, NULL, NULL, capture != 0, 0, NULL,
+                        NULL, &startup_info, &proc_info);
+
+    free(cmdline);
+
+    if (write_pipe != NULL)
+    {
+        CloseHandle(write_pipe);
+    }
+
+    if (!ok)
+    {
+        if (read_pipe != NULL)
+        {
+            CloseHandle(read_pipe);
+        }
+        return NULL;
+    }
+
+    CloseHandle(proc_info.hThread);
+
+    process = NewProcess(output_callback, exit_callback, user_data);
+    process->handle = proc_info.hProcess;
+    process->output = read_pipe;
+    process->spawn_time = MicrosecondsSince(start);
+
+    SDL_LockMutex(process_lock);
+    process->next = processes;
+    processes = process;
+    ++num_processes;
+    SDL_UnlockMutex(process_lock);
+
+    thread = SDL_CreateThread(ProcessThread, "txt_process", process);
+
+    if (thread == NULL)
+    {
+        // We have no way of watching it, so don't leave it running.
+
+        TerminateProcess(process->handle, (UINT) -1);
+
+        SDL_LockMutex(process_lock);
+        processes = process->next;
+        --num_processes;
+        SDL_UnlockMutex(process_lock);
+
+        if (read_pipe != NULL)
+        {
+            CloseHandle(read_pipe);
+        }
+        CloseHandle(process->handle);
+        free(process);
+        return NULL;
+    }
+
+    SDL_DetachThread(thread);
+
+    return process;
+}
+
+#else
+
+// Unix: a single watcher thread polls the output pipes of all processes
+// together with a wakeup pipe. Process exit is signalled either through
+// a pidfd (Linux), or by a SIGCHLD handler that writes to the wakeup
+// pipe.
+
+static int wake_fds[2] = { -1, -1 };
+static int watcher_running;
+static int sigchld_installed;
+
+static void WakeWatcher(void)
+{
+    char c = 0;
+
+    if (write(wake_fds[1], &c, 1) < 0)
+    {
+        // Pipe is full, so the watcher will wake up anyway.
+    }
+}
+
+static void SigchldHandler(int sig)
+{
+    int saved_errno = errno;
+
+    WakeWatcher();
+    errno = saved_errno;
+}
+
+static void InstallSigchldHandler(void)
+{
+    struct sigaction sa;
+
+    if (sigchld_installed)
+    {
+        return;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SigchldHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, NULL);
+
+    sigchld_installed = 1;
+}
+
+static int OpenPidfd(pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    return -1;
+#endif
+}
+
+static void SetNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void SetCloseOnExec(int fd)
+{
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+static int InitWakePipe(void)
+{
+    if (wake_fds[0] >= 0)
+    {
+        return 1;
+    }
+
+    if (pipe(wake_fds) != 0)
+    {
+        return 0;
+    }
+
+    SetNonBlocking(wake_fds[0]);
+    SetNonBlocking(wake_fds[1]);
+    SetCloseOnExec(wake_fds[0]);
+    SetCloseOnExec(wake_fds[1]);
+
+    return 1;
+}
+
+// Check for exited processes and mark processes finished once they have
+// exited and all their output has been read. Must be called with
+// process_lock held. Returns true if anything changed.
+
+static int ReapProcesses(void)
+{
+    txt_process_t *process;
+    int status;
+    int changed = 0;
+
+    for (process = processes; process != NULL; process = process->next)
+    {
+        if (process->finished)
+        {
+            continue;
+        }
+
+        if (!process->exited
+         && waitpid(process->pid, &status, WNOHANG) == process->pid)
+        {
+            process->exited = 1;
+            process->exit_status = WIFEXITED(status) ? WEXITSTATUS(status)
+                                                     : -1;
+        }
+
+        if (process->exited && process->output_fd < 0)
+        {
+            if (process->pidfd >= 0)
+            {
+                close(process->pidfd);
+                process->pidfd = -1;
+            }
+
+            process->finished = 1;
+            changed = 1;
+        }
+    }
+
+    return changed;
+}
+
+// Wait up to 'timeout' ms (-1 for no limit) for something to happen to
+// one of the running processes. Returns false if there is nothing left
+// to watch.
+
+static int WatchProcesses(int timeout)
+{
+    static struct pollfd *fds = NULL;
+    static txt_process_t **owners = NULL;
+    static int max_fds = 0;
+    txt_process_t *process;
+    char buf[64];
+    char *space;
+    size_t len;
+    int num_fds, i;
+    ssize_t bytes;
+    int changed;
+
+    SDL_LockMutex(process_lock);
+
+    changed = ReapProcesses();
+
+    // Build the list of descriptors to wait on: the wakeup pipe, then
+    // output and exit notifiers for each running process.
+
+    num_fds = 1;
+
+    for (process = processes; process != NULL; process = process->next)
+    {
+        if (!process->finished)
+        {
+            num_fds += 2;
+        }
+    }
+
+    if (num_fds == 1)
+    {
+        SDL_UnlockMutex(process_lock);
+
+        if (changed)
+        {
+            WakeMainLoop();
+        }
+        return 0;
+    }
+
+    if (num_fds > max_fds)
+    {
+        max_fds = num_fds;
+        fds = realloc(fds, max_fds * sizeof(struct pollfd));
+        owners = realloc(owners, max_fds * sizeof(txt_process_t *));
+    }
+
+    fds[0].fd = wake_fds[0];
+    fds[0].events = POLLIN;
+    owners[0] = NULL;
+    num_fds = 1;
+
+    for (process = processes; process != NULL; process = process->next)
+    {
+        if (process->finished)
+        {
+            continue;
+        }
+
+        // While the ring is full, the output is left in the pipe. The
+        // main loop wakes us once it has made room.
+
+        if (process->output_fd >= 0
+         && RingUsed(process) < OUTPUT_RING_SIZE)
+        {
+            fds[num_fds].fd = process->output_fd;
+            fds[num_fds].events = POLLIN;
+            owners[num_fds] = process;
+            ++num_fds;
+        }
+
+        if (!process->exited && process->pidfd >= 0)
+        {
+            fds[num_fds].fd = process->pidfd;
+            fds[num_fds].events = POLLIN;
+            owners[num_fds] = NULL;
+            ++num_fds;
+        }
+    }
+
+    SDL_UnlockMutex(process_lock);
+
+    if (changed)
+    {
+        WakeMainLoop();
+    }
+
+    if (poll(fds, num_fds, timeout) <= 0)
+    {
+        return 1;
+    }
+
+    if (fds[0].revents != 0)
+    {
+        while (read(wake_fds[0], buf, sizeof(buf)) > 0);
+    }
+
+    // Read output. Processes can't be freed until we mark them finished,
+    // so it is safe to use them without the lock held.
+
+    changed = 0;
+
+    for (i = 1; i < num_fds; ++i)
+    {
+        process = owners[i];
+
+        if (process == NULL || fds[i].revents == 0)
+        {
+            continue;
+        }
+
+        space = RingWriteSpace(process, &len);
+        bytes = read(fds[i].fd, space, len);
+
+        if (bytes < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            continue;
+        }
+
+        if (bytes > 0)
+        {
+            RingCommitWrite(process, bytes);
+        }
+        else
+        {
+            SDL_LockMutex(process_lock);
+            close(process->output_fd);
+            process->output_fd = -1;
+            SDL_UnlockMutex(process_lock);
+        }
+
+        changed = 1;
+    }
+
+    if (changed)
+    {
+        WakeMainLoop();
+    }
+
+    return 1;
+}
+
+// Returns true if any process has not finished yet. Must be called with
+// process_lock held.
+
+static int ProcessesRunning(void)
+{
+    txt_process_t *process;
+
+    for (process = processes; process != NULL; process = process->next)
+    {
+        if (!process->finished)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int WatcherThread(void *unused)
+{
+    for (;;)
+    {
+        while (WatchProcesses(-1));
+
+        // A process may have been started while we were finishing up.
+
+        SDL_LockMutex(process_lock);
+
+        if (!ProcessesRunning())
+        {
+            watcher_running = 0;
+            SDL_UnlockMutex(process_lock);
+            return 0;
+        }
+
+        SDL_UnlockMutex(process_lock);
+    }
+}
+
+txt_process_t *TXT_SpawnProcess(const char *const *argv, int capture,
+                                TxtProcessOutputFunc output_callback,
+                                TxtProcessExitFunc exit_callback,
+                                void *user_data)
+{
+    posix_spawn_file_actions_t actions;
+    txt_process_t *process;
+    SDL_Thread *thread;
+    int output_pipe[2] = { -1, -1 };
+    Uint64 start;
+    pid_t pid;
+    int err;
+
+    InitProcesses();
+
+    if (!InitWakePipe())
+    {
+        return NULL;
+    }
+
+    posix_spawn_file_actions_init(&actions);
+
+    if (capture != 0)
+    {
+        if (pipe(output_pipe) != 0)
+        {
+            posix_spawn_file_actions_destroy(&actions);
+            return NULL;
+        }
+
+        // The read end is closed in the child by exec; the write end
+        // replaces the streams being captured.
+
+        SetCloseOnExec(output_pipe[0]);
+
+        if (capture & TXT_PROCESS_CAPTURE_STDOUT)
+        {
+            posix_spawn_file_actions_adddup2(&actions, output_pipe[1],
+                                             STDOUT_FILENO);
+        }
+        if (capture & TXT_PROCESS_CAPTURE_STDERR)
+        {
+            posix_spawn_file_actions_adddup2(&actions, output_pipe[1],
+                                             STDERR_FILENO);
+        }
+        posix_spawn_file_actions_addclose(&actions, output_pipe[1]);
+    }
+
+    // Where posix_spawn is built on vfork, it only returns once the
+    // program has been loaded, and reports a failure to exec as an
+    // error. The time it takes is then the real startup latency.
+
+    start = SDL_GetPerformanceCounter();
+    err = posix_spawnp(&pid, argv[0], &actions, NULL,
+                       (char *const *) argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (capture != 0)
+    {
+        close(output_pipe[1]);
+    }
+
+    if (err != 0)
+    {
+        if (capture != 0)
+        {
+            close(output_pipe[0]);
+        }
+        return NULL;
+    }
+
+    process = NewProcess(output_callback, exit_callback, user_data);
+    process->pid = pid;
+    process->spawn_time = MicrosecondsSince(start);
+    process->output_fd = output_pipe[0];
+    process->pidfd = OpenPidfd(pid);
+
+    if (process->output_fd >= 0)
+    {
+        SetNonBlocking(process->output_fd);
+    }
+
+    if (process->pidfd < 0)
+    {
+        InstallSigchldHandler();
+    }
+
+    SDL_LockMutex(process_lock);
+
+    process->next = processes;
+    processes = process;
+    ++num_processes;
+
+    if (!watcher_running)
+    {
+        thread = SDL_CreateThread(WatcherThread, "txt_process", NULL);
+
+        if (thread != NULL)
+        {
+            SDL_DetachThread(thread);
+            watcher_running = 1;
+        }
+    }
+
+    SDL_UnlockMutex(process_lock);
+
+    WakeWatcher();
+
+    return process;
+}
+
+#endif
+
+// Pass the output waiting in a process's ring to its callback.
+
+static void DeliverOutput(txt_process_t *process)
+{
+    const char *data;
+    size_t len;
+#ifndef _WIN32
+    int was_full = RingUsed(process) == OUTPUT_RING_SIZE;
+#endif
+
+    // The filled part of the ring may wrap around the end, so this can
+    // take two calls.
+
+    for (;;)
+    {
+        data = RingReadSpace(process, &len);
+
+        if (len == 0)
+        {
+            break;
+        }
+
+        if (process->output_callback != NULL)
+        {
+            process->output_callback(process, data, len,
+                                     process->user_data);
+        }
+
+        RingCommitRead(process, len);
+    }
+
+#ifndef _WIN32
+    if (was_full)
+    {
+        WakeWatcher();
+    }
+#endif
+}
+
+void TXT_PollProcesses(void)
+{
+    static unsigned int poll_serial;
+    txt_process_t *process, **prev;
+    unsigned int serial;
+    int finished;
+
+    if (process_lock == NULL)
+    {
+        return;
+    }
+
+#ifndef _WIN32
+    // If the watcher thread could not be started, check on the
+    // processes from here.
+
+    SDL_LockMutex(process_lock);
+    finished = !watcher_running && ProcessesRunning();
+    SDL_UnlockMutex(process_lock);
+
+    if (finished)
+    {
+        WatchProcesses(0);
+    }
+#endif
+
+    // Each process is handled at most once per call, so that one that
+    // is producing output quickly can't keep us here.
+
+    serial = ++poll_serial;
+
+    for (;;)
+    {
+        SDL_LockMutex(process_lock);
+
+        for (prev = &processes; *prev != NULL; prev = &(*prev)->next)
+        {
+            if ((*prev)->poll_serial != serial
+             && ((*prev)->finished || RingUsed(*prev) > 0))
+            {
+                break;
+            }
+        }
+
+        process = *prev;
+
+        if (process == NULL)
+        {
+            SDL_UnlockMutex(process_lock);
+            break;
+        }
+
+        process->poll_serial = serial;
+        finished = process->finished;
+
+        if (finished)
+        {
+            *prev = process->next;
+            --num_processes;
+        }
+
+        SDL_UnlockMutex(process_lock);
+
+        // Callbacks are invoked without the lock held, so that they can
+        // start new processes. Once a process has finished, all of its
+        // output is already in the ring.
+
+        DeliverOutput(process);
+
+        if (finished)
+        {
+            if (process->exit_callback != NULL)
+            {
+                process->exit_callback(process, process->exit_status,
+                                       process->user_data);
+            }
+
+            free(process);
+        }
+    }
+}
+
+unsigned int TXT_GetProcessSpawnTime(txt_process_t *process)
+{
+    return process->spawn_time;
+}
+
+int TXT_NumProcesses(void)
+{
+    int result;
+
+    if (process_lock == NULL)
+    {
+        return 0;
+    }
+
+    SDL_LockMutex(process_lock);
+    result = num_processes;
+    SDL_UnlockMutex(process_lock);
+
+    return result;
+}
@@ -0,0 +1,123 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//
+// Asynchronous child processes.
+//
+
+#ifndef TXT_PROCESS_H
+#define TXT_PROCESS_H
+
+/**
+ * @file txt_process.h
+ *
+ * Child processes that run alongside the GUI.
+ */
+
+#include <stddef.h>
+
+/**
+ * A running child process.
+ *
+ * Child processes are watched by a background thread, so the GUI
+ * stays responsive while they run. Each process's output and exit
+ * status are delivered through callback functions, which are always
+ * invoked from @ref TXT_PollProcesses, ie. from the main loop.
+ * Captured output is buffered in a fixed amount of memory; if the GUI
+ * falls behind, the process blocks on writing its output until it
+ * catches up.
+ */
+
+typedef struct txt_process_s txt_process_t;
+
+/**
+ * Callback invoked with a chunk of output from a child process. The
+ * data is not NUL-terminated, and is only valid during the call.
+ */
+
+typedef void (*TxtProcessOutputFunc)(txt_process_t *process,
+                                     const char *data, size_t len,
+                                     void *user_data);
+
+/**
+ * Callback invoked when a child process exits. The exit status is the
+ * value the program exited with, or -1 if it was killed. The process
+ * is freed after the callback returns.
+ */
+
+typedef void (*TxtProcessExitFunc)(txt_process_t *process, int exit_status,
+                                   void *user_data);
+
+/**
+ * Output streams of a child process to capture.
+ */
+
+typedef enum
+{
+    TXT_PROCESS_CAPTURE_STDOUT = 1 << 0,
+    TXT_PROCESS_CAPTURE_STDERR = 1 << 1,
+} txt_process_capture_t;
+
+/**
+ * Start a child process.
+ *
+ * @param argv             NULL-terminated argument list. argv[0] is the
+ *                         path to the program to run. On Windows, the
+ *                         arguments after argv[0] are appended to the
+ *                         command line as they are, so they must already
+ *                         be quoted as needed.
+ * @param capture          Which output streams to capture, as a
+ *                         combination of @ref txt_process_capture_t
+ *                         values. Streams that are not captured stay
+ *                         connected to ours.
+ * @param output_callback  Function to invoke with captured output.
+ * @param exit_callback    Function to invoke when the program exits, or
+ *                         NULL.
+ * @param user_data        User-specified pointer to pass to the callback
+ *                         functions.
+ * @return                 The new process, or NULL if the program could
+ *                         not be started.
+ */
+
+txt_process_t *TXT_SpawnProcess(const char *const *argv, int capture,
+                                TxtProcessOutputFunc output_callback,
+                                TxtProcessExitFunc exit_callback,
+                                void *user_data);
+
+/**
+ * Get the time it took to start a child process, in microseconds. On
+ * most Unix systems this runs until the program has been loaded and
+ * started; on Windows, until the process has been created.
+ *
+ * @param process          The process.
+ * @return                 The startup time.
+ */
+
+unsigned int TXT_GetProcessSpawnTime(txt_process_t *process);
+
+/**
+ * Deliver any pending output and exit notifications from child
+ * processes. This is called by the main loop; code that runs its own
+ * loop must call it too.
+ */
+
+void TXT_PollProcesses(void);
+
+/**
+ * Get the number of child processes that are still running, or that
+ * have exited but whose exit callback has not yet been invoked.
+ */
+
+int TXT_NumProcesses(void);
+
+#endif /* #ifndef TXT_PROCESS_H */
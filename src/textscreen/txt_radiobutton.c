@@ -35,7 +35,6 @@ static void TXT_RadioButtonDrawer(TXT_UNCAST_ARG(radiobutton))
 {
     TXT_CAST_ARG(txt_radiobutton_t, radiobutton);
     txt_saved_colors_t colors;
-    int i;
     int w;
 
     w = radiobutton->widget.w;
@@ -64,10 +63,7 @@ static void TXT_RadioButtonDrawer(TXT_UNCAST_ARG(radiobutton))
 
     TXT_DrawString(radiobutton->label);
 
-    for (i=TXT_UTF8_Strlen(radiobutton->label); i < w-5; ++i)
-    {
-        TXT_DrawString(" ");
-    }
+    TXT_FillSpan(' ', w - 5 - (int) TXT_UTF8_Strlen(radiobutton->label));
 }
 
 static void TXT_RadioButtonDestructor(TXT_UNCAST_ARG(radiobutton))
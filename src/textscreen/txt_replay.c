@@ -0,0 +1,405 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Recording and replay of input events.
+//
+// A recording is a short header followed by one record per event: the
+// time since the previous event in ms and the key code, as variable-
+// length integers, then the mouse position and modifier keys in a byte
+// each.
+//
+
+#include "SDL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "txt_desktop.h"
+#include "txt_main.h"
+#include "txt_perf.h"
+#include "txt_replay.h"
+
+#define REPLAY_MAGIC   "TXRP"
+#define REPLAY_VERSION 1
+
+// Most events that can be waiting to be presented at once; any more are
+// not measured.
+
+#define MAX_PENDING 64
+
+typedef struct
+{
+    unsigned int time;          // ms since the start of the recording
+    int key;                    // 0 if the mouse only moved
+    unsigned char mouse_x;
+    unsigned char mouse_y;
+    unsigned char modifiers;    // bit (1 << n) for txt_modifier_t n
+} txt_replay_event_t;
+
+static FILE *record_file = NULL;
+static unsigned int record_last;
+
+static txt_replay_event_t *replay_events = NULL;
+static int replay_num_events;
+static int replay_next;
+static txt_replay_speed_t replay_speed;
+static unsigned int replay_start;
+static const txt_replay_event_t *replay_current;
+
+// Times events were dispatched at, until they are presented.
+
+static unsigned int pending_times[MAX_PENDING];
+static int num_pending;
+
+// Dispatch-to-present latency of each event, in microseconds.
+
+static unsigned int *latencies;
+static int num_latencies;
+
+static void WriteVarint(unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        fputc((value & 0x7f) | 0x80, record_file);
+        value >>= 7;
+    }
+
+    fputc(value, record_file);
+}
+
+static int ReadVarint(FILE *fstream, unsigned int *value)
+{
+    int shift, c;
+
+    *value = 0;
+
+    for (shift = 0; shift < 32; shift += 7)
+    {
+        c = fgetc(fstream);
+
+        if (c == EOF)
+        {
+            return 0;
+        }
+
+        *value |= (unsigned int) (c & 0x7f) << shift;
+
+        if ((c & 0x80) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void TXT_StopRecording(void)
+{
+    if (record_file != NULL)
+    {
+        fclose(record_file);
+        record_file = NULL;
+    }
+}
+
+int TXT_StartRecording(const char *filename)
+{
+    static int atexit_set = 0;
+
+    TXT_StopRecording();
+
+    record_file = fopen(filename, "wb");
+
+    if (record_file == NULL)
+    {
+        return 0;
+    }
+
+    fputs(REPLAY_MAGIC, record_file);
+    fputc(REPLAY_VERSION, record_file);
+
+    record_last = SDL_GetTicks();
+
+    if (!atexit_set)
+    {
+        atexit(TXT_StopRecording);
+        atexit_set = 1;
+    }
+
+    return 1;
+}
+
+void TXT_RecordEvent(int c)
+{
+    unsigned int now;
+    int modifiers = 0;
+    int x, y, i;
+
+    if (record_file == NULL)
+    {
+        return;
+    }
+
+    now = SDL_GetTicks();
+    TXT_GetMousePosition(&x, &y);
+
+    for (i = 0; i < TXT_NUM_MODIFIERS; ++i)
+    {
+        if (TXT_GetModifierState(i))
+        {
+            modifiers |= 1 << i;
+        }
+    }
+
+    WriteVarint(now - record_last);
+    WriteVarint(c);
+    fputc(x, record_file);
+    fputc(y, record_file);
+    fputc(modifiers, record_file);
+
+    record_last = now;
+}
+
+int TXT_StartReplay(const char *filename, txt_replay_speed_t speed)
+{
+    char magic[sizeof(REPLAY_MAGIC)];
+    txt_replay_event_t ev;
+    unsigned int delta, key, time = 0;
+    int num_events = 0, events_size = 256;
+    FILE *fstream;
+
+    fstream = fopen(filename, "rb");
+
+    if (fstream == NULL)
+    {
+        return 0;
+    }
+
+    if (fread(magic, 1, sizeof(magic), fstream) != sizeof(magic)
+     || memcmp(magic, REPLAY_MAGIC, sizeof(magic) - 1) != 0
+     || magic[sizeof(magic) - 1] != REPLAY_VERSION)
+    {
+        fclose(fstream);
+        return 0;
+    }
+
+    // Allocated even if there are no events, so that an empty recording
+    // is still a replay, which finishes straight away.
+
+    free(replay_events);
+    replay_events = malloc(events_size * sizeof(*replay_events));
+
+    while (ReadVarint(fstream, &delta) && ReadVarint(fstream, &key))
+    {
+        int x = fgetc(fstream);
+        int y = fgetc(fstream);
+        int modifiers = fgetc(fstream);
+
+        if (modifiers == EOF)
+        {
+            break;
+        }
+
+        time += delta;
+        ev.time = time;
+        ev.key = (int) key;
+        ev.mouse_x = x;
+        ev.mouse_y = y;
+        ev.modifiers = modifiers;
+
+        if (num_events == events_size)
+        {
+            events_size *= 2;
+            replay_events = realloc(replay_events,
+                                    events_size * sizeof(*replay_events));
+        }
+
+        replay_events[num_events++] = ev;
+    }
+
+    fclose(fstream);
+
+    replay_num_events = num_events;
+    replay_next = 0;
+    replay_speed = speed;
+    replay_start = SDL_GetTicks();
+    replay_current = NULL;
+    num_pending = 0;
+
+    free(latencies);
+    latencies = malloc(sizeof(*latencies) * (num_events > 0 ? num_events : 1));
+    num_latencies = 0;
+
+    return 1;
+}
+
+int TXT_Replaying(void)
+{
+    return replay_events != NULL;
+}
+
+int TXT_ReplayNextEvent(void)
+{
+    const txt_replay_event_t *ev;
+
+    if (replay_events == NULL || replay_next >= replay_num_events)
+    {
+        return -1;
+    }
+
+    ev = &replay_events[replay_next];
+
+    if (replay_speed == TXT_REPLAY_PACED)
+    {
+        if (SDL_GetTicks() - replay_start < ev->time)
+        {
+            return -1;
+        }
+    }
+    else if (num_pending > 0)
+    {
+        // As fast as possible, but still one frame per event.
+
+        return -1;
+    }
+
+    ++replay_next;
+    replay_current = ev;
+
+    if (num_pending < MAX_PENDING)
+    {
+        pending_times[num_pending++] = TXT_PerfTime();
+    }
+
+    return ev->key;
+}
+
+void TXT_ReplayPresented(void)
+{
+    unsigned int now;
+    int i;
+
+    if (num_pending == 0)
+    {
+        return;
+    }
+
+    now = TXT_PerfTime();
+
+    for (i = 0; i < num_pending; ++i)
+    {
+        latencies[num_latencies++] = now - pending_times[i];
+    }
+
+    num_pending = 0;
+}
+
+static int CompareLatencies(const void *a, const void *b)
+{
+    unsigned int la = *(const unsigned int *) a;
+    unsigned int lb = *(const unsigned int *) b;
+
+    return la < lb ? -1 : la > lb ? 1 : 0;
+}
+
+static void FinishReplay(void)
+{
+    unsigned long long total = 0;
+    int i;
+
+    if (num_latencies > 0)
+    {
+        qsort(latencies, num_latencies, sizeof(*latencies), CompareLatencies);
+
+        for (i = 0; i < num_latencies; ++i)
+        {
+            total += latencies[i];
+        }
+
+        printf("Replayed %d events in %u ms; latency in ms: mean %.2f, "
+               "median %.2f, 95th percentile %.2f, max %.2f\n",
+               replay_num_events, SDL_GetTicks() - replay_start,
+               total / 1000.0 / num_latencies,
+               latencies[num_latencies / 2] / 1000.0,
+               latencies[num_latencies * 95 / 100] / 1000.0,
+               latencies[num_latencies - 1] / 1000.0);
+    }
+    else
+    {
+        printf("Replayed %d events in %u ms\n",
+               replay_num_events, SDL_GetTicks() - replay_start);
+    }
+
+    free(replay_events);
+    replay_events = NULL;
+    free(latencies);
+    latencies = NULL;
+    replay_current = NULL;
+
+    TXT_ExitMainLoop();
+}
+
+void TXT_ReplayWait(void)
+{
+    unsigned int now, due;
+
+    if (replay_events == NULL)
+    {
+        return;
+    }
+
+    if (replay_next >= replay_num_events && num_pending == 0)
+    {
+        FinishReplay();
+        return;
+    }
+
+    if (replay_speed == TXT_REPLAY_PACED && replay_next < replay_num_events)
+    {
+        now = SDL_GetTicks() - replay_start;
+        due = replay_events[replay_next].time;
+
+        if (due > now)
+        {
+            SDL_Delay(due - now < 50 ? due - now : 50);
+        }
+    }
+}
+
+int TXT_ReplayMousePosition(int *x, int *y)
+{
+    if (replay_current == NULL)
+    {
+        return 0;
+    }
+
+    *x = replay_current->mouse_x;
+    *y = replay_current->mouse_y;
+
+    return 1;
+}
+
+int TXT_ReplayModifierState(txt_modifier_t mod, int *state)
+{
+    if (replay_current == NULL)
+    {
+        return 0;
+    }
+
+    *state = (replay_current->modifiers & (1 << mod)) != 0;
+
+    return 1;
+}
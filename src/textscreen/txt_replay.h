@@ -0,0 +1,92 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Recording and replay of input events.
+//
+
+#ifndef TXT_REPLAY_H
+#define TXT_REPLAY_H
+
+/**
+ * @file txt_replay.h
+ *
+ * Recording and replay of input events.
+ *
+ * The events recorded are the key and mouse codes read by
+ * @ref TXT_DispatchEvents, along with when they arrived and where the
+ * mouse was, so a replay goes through the same dispatch path as the
+ * original input did. While replaying, the time from dispatching each
+ * event to the screen next being presented is measured.
+ */
+
+#include "txt_main.h"
+
+/**
+ * How fast to replay events.
+ */
+
+typedef enum
+{
+    /** With the same timing as when they were recorded. */
+    TXT_REPLAY_PACED,
+
+    /** One per frame, as fast as the screen can be drawn. */
+    TXT_REPLAY_FAST,
+} txt_replay_speed_t;
+
+/**
+ * Start recording events to a file. Recording stops at exit.
+ *
+ * @param filename       The file to write.
+ * @return               Non-zero if the file could be opened.
+ */
+
+int TXT_StartRecording(const char *filename);
+
+/**
+ * Stop recording events, and close the file.
+ */
+
+void TXT_StopRecording(void);
+
+/**
+ * Start replaying events from a file recorded by
+ * @ref TXT_StartRecording. Input from the user is ignored until the
+ * replay is finished; then the main loop exits, and a summary of the
+ * latency of each event is printed.
+ *
+ * @param filename       The file to read.
+ * @param speed          How fast to replay the events.
+ * @return               Non-zero if the file is a valid recording.
+ */
+
+int TXT_StartReplay(const char *filename, txt_replay_speed_t speed);
+
+/**
+ * Get whether events are being replayed.
+ */
+
+int TXT_Replaying(void);
+
+// Internal interface, for the main loop and backends.
+
+void TXT_RecordEvent(int c);
+int TXT_ReplayNextEvent(void);
+void TXT_ReplayWait(void);
+void TXT_ReplayPresented(void);
+int TXT_ReplayMousePosition(int *x, int *y);
+int TXT_ReplayModifierState(txt_modifier_t mod, int *state);
+
+#endif /* #ifndef TXT_REPLAY_H */
@@ -24,8 +24,13 @@
 
 #include "doomkeys.h"
 #include "txt_main.h"
+#include "txt_perf.h"
+#include "txt_replay.h"
 #include "txt_sdl.h"
+#include "txt_term.h"
 #include "txt_utf8.h"
+#include "../elib/crc32.h"
+#include "../elib/trace.h"
 
 // haleyjd: unnecessary in any recent version
 //#if defined(_MSC_VER) && !defined(__cplusplus)
@@ -51,11 +56,21 @@ typedef struct
 
 #define BLINK_PERIOD 250
 
+static txt_backend_t backend = TXT_BACKEND_WINDOW;
+
 SDL_Window *TXT_SDLWindow;
 static SDL_Surface *screenbuffer;
 static unsigned char *screendata;
 static SDL_Renderer *renderer;
 
+// Copy of the screen data as it was last rendered, so that characters
+// which have not changed are not rendered again, and updates which
+// change nothing are not presented at all.
+static unsigned char *shownscreendata;
+static int shown_blink_phase;
+static int render_all;       // shownscreendata is not valid
+static int present_needed;   // the window must be presented again anyway
+
 // Current input mode.
 static txt_input_mode_t input_mode = TXT_INPUT_NORMAL;
 
@@ -63,6 +78,20 @@ static txt_input_mode_t input_mode = TXT_INPUT_NORMAL;
 // is the value that was passed to SDL_CreateWindow().
 static int screen_image_w, screen_image_h;
 
+// Size of the window in screen coordinates, kept up to date from window
+// events so it need not be asked for on every mouse movement.
+static int window_w, window_h;
+
+// Keys still to be returned by TXT_GetChar from text input events that
+// contained more than one character.
+#define MAX_PENDING_KEYS 64
+static int pending_keys[MAX_PENDING_KEYS];
+static unsigned int pending_keys_head, pending_keys_tail;
+
+// Mouse position in characters, as of the last mouse motion event.
+static int motion_x, motion_y;
+static int motion_pending;
+
 static TxtSDLEventCallbackFunc event_callback;
 static void *event_callback_data;
 
@@ -276,13 +305,9 @@ static void ChooseFont(void)
     }
 }
 
-//
-// Initialize text mode screen
-//
-// Returns 1 if successful, 0 if an error occurred
-//
+// Open the window and renderer, and choose a font to suit the display.
 
-int TXT_Init(void)
+static int OpenWindow(void)
 {
     int flags = 0;
 
@@ -309,6 +334,8 @@ int TXT_Init(void)
     if (TXT_SDLWindow == NULL)
         return 0;
 
+    SDL_GetWindowSize(TXT_SDLWindow, &window_w, &window_h);
+
     renderer = SDL_CreateRenderer(TXT_SDLWindow, -1, SDL_RENDERER_SOFTWARE);
 
     // Special handling for OS X retina display. If we successfully set the
@@ -337,6 +364,51 @@ int TXT_Init(void)
         font = &normal_font;
     }
 
+    return 1;
+}
+
+void TXT_SetBackend(txt_backend_t new_backend)
+{
+    backend = new_backend;
+}
+
+txt_backend_t TXT_GetBackend(void)
+{
+    return backend;
+}
+
+//
+// Initialize text mode screen
+//
+// Returns 1 if successful, 0 if an error occurred
+//
+
+int TXT_Init(void)
+{
+    switch (backend)
+    {
+        case TXT_BACKEND_WINDOW:
+            if (!OpenWindow())
+            {
+                return 0;
+            }
+            break;
+
+        case TXT_BACKEND_TERMINAL:
+            if (!TXT_Term_Init())
+            {
+                return 0;
+            }
+            // fall through
+
+        case TXT_BACKEND_OFFSCREEN:
+            // Always the same font, so that screens can be compared.
+            font = &normal_font;
+            screen_image_w = TXT_SCREEN_W * font->w;
+            screen_image_h = TXT_SCREEN_H * font->h;
+            break;
+    }
+
     // Instead, we draw everything into an intermediate 8-bit surface
     // the same dimensions as the screen. SDL then takes care of all the
     // 8->32 bit (or whatever depth) color conversions for us.
@@ -352,6 +424,9 @@ int TXT_Init(void)
     screendata = malloc(TXT_SCREEN_W * TXT_SCREEN_H * 2);
     memset(screendata, 0, TXT_SCREEN_W * TXT_SCREEN_H * 2);
 
+    shownscreendata = malloc(TXT_SCREEN_W * TXT_SCREEN_H * 2);
+    render_all = 1;
+
     return 1;
 }
 
@@ -359,9 +434,19 @@ void TXT_Shutdown(void)
 {
     free(screendata);
     screendata = NULL;
+    free(shownscreendata);
+    shownscreendata = NULL;
     SDL_FreeSurface(screenbuffer);
     screenbuffer = NULL;
-    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+    if (backend == TXT_BACKEND_WINDOW)
+    {
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    }
+    else if (backend == TXT_BACKEND_TERMINAL)
+    {
+        TXT_Term_Shutdown();
+    }
 }
 
 void TXT_SetColor(txt_color_t color, int r, int g, int b)
@@ -371,6 +456,10 @@ void TXT_SetColor(txt_color_t color, int r, int g, int b)
     SDL_LockSurface(screenbuffer);
     SDL_SetPaletteColors(screenbuffer->format->palette, &c, color, 1);
     SDL_UnlockSurface(screenbuffer);
+
+    present_needed = 1;
+
+    TXT_Term_SetColor(color, r, g, b);
 }
 
 unsigned char *TXT_GetScreenData(void)
@@ -378,6 +467,19 @@ unsigned char *TXT_GetScreenData(void)
     return screendata;
 }
 
+// Whether blinking characters are currently shown (1) or hidden (0).
+// Offscreen, they are always hidden, so that screens can be compared.
+
+static int BlinkPhase(void)
+{
+    if (backend == TXT_BACKEND_OFFSCREEN)
+    {
+        return 0;
+    }
+
+    return (SDL_GetTicks() / BLINK_PERIOD) % 2;
+}
+
 static inline void UpdateCharacter(int x, int y)
 {
     unsigned char character;
@@ -399,7 +501,7 @@ static inline void UpdateCharacter(int x, int y)
 
         bg &= ~0x8;
 
-        if (((SDL_GetTicks() / BLINK_PERIOD) % 2) == 0)
+        if (BlinkPhase() == 0)
         {
             fg = bg;
         }
@@ -474,6 +576,26 @@ void TXT_UpdateScreenArea(int x, int y, int w, int h)
     int x1, y1;
     int x_end;
     int y_end;
+    int blink_phase, blink_changed;
+    int changed = 0;
+    unsigned int start;
+
+    TRACE_BEGIN(trace);
+
+    start = TXT_PerfTime();
+
+    // The terminal is sent whatever has changed on the whole screen.
+
+    if (backend == TXT_BACKEND_TERMINAL)
+    {
+        unsigned int sent = TXT_Term_UpdateScreen(screendata);
+
+        TXT_PerfCount(TXT_PERF_RASTER, TXT_PerfTime() - start);
+        TXT_PerfCount(sent > 0 ? TXT_PERF_UPLOADED : TXT_PERF_SKIPPED,
+                      sent > 0 ? sent : 1);
+        TRACE_END(trace, "TXT_UpdateScreenArea");
+        return;
+    }
 
     SDL_LockSurface(screenbuffer);
 
@@ -482,28 +604,74 @@ void TXT_UpdateScreenArea(int x, int y, int w, int h)
     x = LimitToRange(x, 0, TXT_SCREEN_W);
     y = LimitToRange(y, 0, TXT_SCREEN_H);
 
+    blink_phase = BlinkPhase();
+    blink_changed = blink_phase != shown_blink_phase;
+
     for (y1=y; y1<y_end; ++y1)
     {
         for (x1=x; x1<x_end; ++x1)
         {
-            UpdateCharacter(x1, y1);
+            unsigned char *p = &screendata[(y1 * TXT_SCREEN_W + x1) * 2];
+            unsigned char *shown = &shownscreendata[p - screendata];
+
+            // Blinking characters change with the blink phase alone.
+
+            if (render_all || p[0] != shown[0] || p[1] != shown[1]
+             || (blink_changed && (p[1] & 0x80) != 0))
+            {
+                UpdateCharacter(x1, y1);
+                shown[0] = p[0];
+                shown[1] = p[1];
+                changed = 1;
+            }
         }
     }
 
     SDL_UnlockSurface(screenbuffer);
 
+    if (x == 0 && y == 0 && x_end == TXT_SCREEN_W && y_end == TXT_SCREEN_H)
+    {
+        render_all = 0;
+        shown_blink_phase = blink_phase;
+    }
+
+    TXT_PerfCount(TXT_PERF_RASTER, TXT_PerfTime() - start);
+
+    if (!changed && !present_needed)
+    {
+        TXT_PerfCount(TXT_PERF_SKIPPED, 1);
+        TRACE_END(trace, "TXT_UpdateScreenArea");
+        return;
+    }
+
+    present_needed = 0;
+
+    if (backend == TXT_BACKEND_OFFSCREEN)
+    {
+        TRACE_END(trace, "TXT_UpdateScreenArea");
+        return;
+    }
+
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
 
     // TODO: This is currently creating a new texture every time we render
     // the screen; find a more efficient way to do it.
     screentx = SDL_CreateTextureFromSurface(renderer, screenbuffer);
+    TXT_PerfCount(TXT_PERF_UPLOADED, screenbuffer->pitch * screenbuffer->h);
 
     SDL_RenderClear(renderer);
     GetDestRect(&rect);
     SDL_RenderCopy(renderer, screentx, NULL, &rect);
-    SDL_RenderPresent(renderer);
+
+    {
+        TRACE_BEGIN(present);
+        SDL_RenderPresent(renderer);
+        TRACE_END(present, "SDL_RenderPresent");
+    }
 
     SDL_DestroyTexture(screentx);
+
+    TRACE_END(trace, "TXT_UpdateScreenArea");
 }
 
 void TXT_UpdateScreen(void)
@@ -511,18 +679,73 @@ void TXT_UpdateScreen(void)
     TXT_UpdateScreenArea(0, 0, TXT_SCREEN_W, TXT_SCREEN_H);
 }
 
-void TXT_GetMousePosition(int *x, int *y)
+int TXT_SaveScreenImage(const char *filename)
 {
-    int window_w, window_h;
-    int origin_x, origin_y;
+    const SDL_Color *colors = screenbuffer->format->palette->colors;
+    const unsigned char *row;
+    FILE *fstream;
+    int x, y;
 
-    SDL_GetMouseState(x, y);
+    fstream = fopen(filename, "wb");
+
+    if (fstream == NULL)
+    {
+        return 0;
+    }
+
+    fprintf(fstream, "P6\n%d %d\n255\n", screenbuffer->w, screenbuffer->h);
+
+    SDL_LockSurface(screenbuffer);
+
+    for (y = 0; y < screenbuffer->h; ++y)
+    {
+        row = (const unsigned char *) screenbuffer->pixels
+            + y * screenbuffer->pitch;
+
+        for (x = 0; x < screenbuffer->w; ++x)
+        {
+            const SDL_Color *c = &colors[row[x]];
+
+            fputc(c->r, fstream);
+            fputc(c->g, fstream);
+            fputc(c->b, fstream);
+        }
+    }
+
+    SDL_UnlockSurface(screenbuffer);
+
+    return fclose(fstream) == 0;
+}
+
+unsigned int TXT_HashScreenImage(void)
+{
+    const SDL_Palette *palette = screenbuffer->format->palette;
+    uint32_t crc = 0;
+    int y;
+
+    SDL_LockSurface(screenbuffer);
 
-    // Translate mouse position from 'pixel' position into character position.
-    // We are working here in screen coordinates and not pixels, since this is
-    // what SDL_GetWindowSize() returns; we must calculate and subtract the
+    for (y = 0; y < screenbuffer->h; ++y)
+    {
+        crc = E_CRC32(crc, (const unsigned char *) screenbuffer->pixels
+                         + y * screenbuffer->pitch, screenbuffer->w);
+    }
+
+    SDL_UnlockSurface(screenbuffer);
+
+    return E_CRC32(crc, palette->colors, 16 * sizeof(SDL_Color));
+}
+
+// Translate a mouse position in screen coordinates into a character
+// position.
+
+static void WindowToScreenPosition(int *x, int *y)
+{
+    int origin_x, origin_y;
+
+    // We are working here in screen coordinates and not pixels, since this
+    // is what the window size is in; we must calculate and subtract the
     // origin position since we center the image within the window.
-    SDL_GetWindowSize(TXT_SDLWindow, &window_w, &window_h);
     origin_x = (window_w - screen_image_w) / 2;
     origin_y = (window_h - screen_image_h) / 2;
     *x = ((*x - origin_x) * TXT_SCREEN_W) / screen_image_w;
@@ -546,6 +769,29 @@ void TXT_GetMousePosition(int *x, int *y)
     }
 }
 
+void TXT_GetMousePosition(int *x, int *y)
+{
+    if (TXT_ReplayMousePosition(x, y))
+    {
+        return;
+    }
+
+    if (backend == TXT_BACKEND_OFFSCREEN)
+    {
+        *x = 0;
+        *y = 0;
+        return;
+    }
+    else if (backend == TXT_BACKEND_TERMINAL)
+    {
+        TXT_Term_GetMousePosition(x, y);
+        return;
+    }
+
+    SDL_GetMouseState(x, y);
+    WindowToScreenPosition(x, y);
+}
+
 //
 // Translates the SDL key
 //
@@ -602,6 +848,63 @@ static int TranslateKeysym(const SDL_Keysym *sym)
     }
 }
 
+// Make an SDL key press event for a key read from the terminal, for event
+// callbacks that expect them. Returns 0 if the key has no SDL equivalent.
+
+static int TerminalKeyEvent(int key, SDL_Event *ev)
+{
+    SDL_Scancode scancode = SDL_SCANCODE_UNKNOWN;
+    SDL_Keycode sym;
+    int i;
+
+    if (key >= 'A' && key <= 'Z')
+    {
+        key = tolower(key);
+    }
+
+    for (i = 0; i < arrlen(scancode_translate_table); ++i)
+    {
+        if (scancode_translate_table[i] == key)
+        {
+            scancode = (SDL_Scancode) i;
+            break;
+        }
+    }
+
+    switch (key)
+    {
+        case KEY_ENTER:     sym = SDLK_RETURN;    break;
+        case KEY_ESCAPE:    sym = SDLK_ESCAPE;    break;
+        case KEY_TAB:       sym = SDLK_TAB;       break;
+        case KEY_BACKSPACE: sym = SDLK_BACKSPACE; break;
+        case KEY_DEL:       sym = SDLK_DELETE;    break;
+
+        default:
+            if (key >= 0x20 && key < 0x7f)
+            {
+                // Keycodes of printable keys are their characters.
+                sym = key;
+            }
+            else if (scancode != SDL_SCANCODE_UNKNOWN)
+            {
+                sym = SDL_SCANCODE_TO_KEYCODE(scancode);
+            }
+            else
+            {
+                return 0;
+            }
+            break;
+    }
+
+    SDL_zerop(ev);
+    ev->type = SDL_KEYDOWN;
+    ev->key.state = SDL_PRESSED;
+    ev->key.keysym.scancode = scancode;
+    ev->key.keysym.sym = sym;
+
+    return 1;
+}
+
 // Convert an SDL button index to textscreen button index.
 //
 // Note special cases because 2 == mid in SDL, 3 == mid in textscreen/setup
@@ -635,16 +938,16 @@ static int SDLWheelToTXTButton(const SDL_MouseWheelEvent *wheel)
     }
 }
 
+// Check whether the mouse has moved to a different character since the
+// last mouse motion was returned by TXT_GetChar.
+
 static int MouseHasMoved(void)
 {
     static int last_x = 0, last_y = 0;
-    int x, y;
-
-    TXT_GetMousePosition(&x, &y);
 
-    if (x != last_x || y != last_y)
+    if (motion_x != last_x || motion_y != last_y)
     {
-        last_x = x; last_y = y;
+        last_x = motion_x; last_y = motion_y;
         return 1;
     }
     else
@@ -653,10 +956,59 @@ static int MouseHasMoved(void)
     }
 }
 
+// Queue all the characters of a text input event after the first as keys,
+// and return the first.
+
+static int TextInputKeys(const char *text)
+{
+    const char *p = text;
+    unsigned int u;
+    int result;
+
+    result = TXT_DecodeUTF8(&p);
+
+    while (*p != '\0'
+        && pending_keys_tail - pending_keys_head < MAX_PENDING_KEYS)
+    {
+        // 0-127 is ASCII, but we map non-ASCII Unicode chars into
+        // a higher range to avoid conflicts with special keys.
+        u = TXT_DecodeUTF8(&p);
+        pending_keys[pending_keys_tail % MAX_PENDING_KEYS] =
+            TXT_UNICODE_TO_KEY(u);
+        ++pending_keys_tail;
+    }
+
+    return TXT_UNICODE_TO_KEY(result);
+}
+
 signed int TXT_GetChar(void)
 {
     SDL_Event ev;
 
+    if (backend == TXT_BACKEND_TERMINAL)
+    {
+        int key = TXT_Term_GetChar();
+
+        // Let the event callback intercept key presses, as it would in a
+        // window. Mouse buttons are not keys.
+
+        if (key >= 0 && key < TXT_MOUSE_BASE && event_callback != NULL
+         && TerminalKeyEvent(key, &ev)
+         && event_callback(&ev, event_callback_data))
+        {
+            return -1;
+        }
+
+        return key;
+    }
+
+    // Characters left over from an earlier text input event come first.
+
+    if (pending_keys_head != pending_keys_tail)
+    {
+        return pending_keys[pending_keys_head++ % MAX_PENDING_KEYS];
+    }
+
     while (SDL_PollEvent(&ev))
     {
         // If there is an event callback, allow it to intercept this
@@ -705,14 +1057,9 @@ signed int TXT_GetChar(void)
                 break;
 
             case SDL_TEXTINPUT:
-                if (input_mode == TXT_INPUT_TEXT)
+                if (input_mode == TXT_INPUT_TEXT && ev.text.text[0] != '\0')
                 {
-                    // TODO: Support input of more than just the first char?
-                    const char *p = ev.text.text;
-                    int result = TXT_DecodeUTF8(&p);
-                    // 0-127 is ASCII, but we map non-ASCII Unicode chars into
-                    // a higher range to avoid conflicts with special keys.
-                    return TXT_UNICODE_TO_KEY(result);
+                    return TextInputKeys(ev.text.text);
                 }
                 break;
 
@@ -720,23 +1067,63 @@ signed int TXT_GetChar(void)
                 // Quit = escape
                 return 27;
 
-            case SDL_MOUSEMOTION:
-                if (MouseHasMoved())
+            case SDL_WINDOWEVENT:
+                // The window may have been resized or uncovered, so the
+                // screen must be presented again even if it is unchanged.
+                if (ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
                 {
-                    return 0;
+                    window_w = ev.window.data1;
+                    window_h = ev.window.data2;
                 }
+                present_needed = 1;
+                break;
+
+            case SDL_MOUSEMOTION:
+                // Only the last of a run of motion events matters, so
+                // just remember where it was until the queue is empty.
+                motion_x = ev.motion.x;
+                motion_y = ev.motion.y;
+                WindowToScreenPosition(&motion_x, &motion_y);
+                motion_pending = 1;
+                break;
 
             default:
                 break;
         }
     }
 
+    // Mouse movement is reported once the queue is drained, so that a
+    // burst of it causes one redraw rather than one for each event.
+
+    if (motion_pending)
+    {
+        motion_pending = 0;
+
+        if (MouseHasMoved())
+        {
+            return 0;
+        }
+    }
+
     return -1;
 }
 
 int TXT_GetModifierState(txt_modifier_t mod)
 {
     SDL_Keymod state;
+    int replayed;
+
+    if (TXT_ReplayModifierState(mod, &replayed))
+    {
+        return replayed;
+    }
+
+    // Terminals do not tell us about modifier keys on their own.
+
+    if (backend == TXT_BACKEND_TERMINAL)
+    {
+        return 0;
+    }
 
     state = SDL_GetModState();
 
@@ -753,18 +1140,95 @@ int TXT_GetModifierState(txt_modifier_t mod)
     }
 }
 
+// Reverse of code_page_to_unicode: a direct table for the first 256
+// characters, which include ASCII and Latin-1, and a small hash table
+// for the rest.
+
+#define UNICODE_HASH_SIZE 512   // power of two, at least twice 256
+
+static short latin1_to_code_page[256];
+static struct
+{
+    unsigned short unicode;     // 0 if this slot is empty
+    unsigned char code_page;
+} unicode_hash[UNICODE_HASH_SIZE];
+static int reverse_built = 0;
+
+static unsigned int UnicodeHash(unsigned int c)
+{
+    return ((c * 2654435761u) >> 23) & (UNICODE_HASH_SIZE - 1);
+}
+
+static void BuildReverseCodePage(void)
+{
+    unsigned int i, c, h;
+
+    for (i = 0; i < arrlen(latin1_to_code_page); ++i)
+    {
+        latin1_to_code_page[i] = -1;
+    }
+
+    for (i = 0; i < arrlen(code_page_to_unicode); ++i)
+    {
+        c = code_page_to_unicode[i];
+
+        // Where a character appears more than once, the first wins.
+
+        if (c < arrlen(latin1_to_code_page))
+        {
+            if (latin1_to_code_page[c] < 0)
+            {
+                latin1_to_code_page[c] = i;
+            }
+            continue;
+        }
+
+        for (h = UnicodeHash(c); unicode_hash[h].unicode != 0;
+             h = (h + 1) & (UNICODE_HASH_SIZE - 1))
+        {
+            if (unicode_hash[h].unicode == c)
+            {
+                break;
+            }
+        }
+
+        if (unicode_hash[h].unicode == 0)
+        {
+            unicode_hash[h].unicode = c;
+            unicode_hash[h].code_page = i;
+        }
+    }
+
+    reverse_built = 1;
+}
+
 int TXT_UnicodeCharacter(unsigned int c)
 {
-    unsigned int i;
+    unsigned int h;
+
+    if (!reverse_built)
+    {
+        BuildReverseCodePage();
+    }
 
     // Check the code page mapping to see if this character maps
     // to anything.
 
-    for (i = 0; i < arrlen(code_page_to_unicode); ++i)
+    if (c < arrlen(latin1_to_code_page))
+    {
+        return latin1_to_code_page[c];
+    }
+    else if (c > 0xffff)
     {
-        if (code_page_to_unicode[i] == c)
+        return -1;
+    }
+
+    for (h = UnicodeHash(c); unicode_hash[h].unicode != 0;
+         h = (h + 1) & (UNICODE_HASH_SIZE - 1))
+    {
+        if (unicode_hash[h].unicode == c)
         {
-            return i;
+            return unicode_hash[h].code_page;
         }
     }
 
@@ -895,6 +1359,21 @@ void TXT_Sleep(int timeout)
 {
     unsigned int start_time;
 
+    // Nothing can happen offscreen that is worth waiting for.
+
+    if (backend == TXT_BACKEND_OFFSCREEN)
+    {
+        return;
+    }
+
+    // The terminal makes characters blink by itself.
+
+    if (backend == TXT_BACKEND_TERMINAL)
+    {
+        TXT_Term_Sleep(timeout);
+        return;
+    }
+
     if (TXT_ScreenHasBlinkingChars())
     {
         int time_to_next_blink;
@@ -957,7 +1436,14 @@ void TXT_SetInputMode(txt_input_mode_t mode)
 
 void TXT_SetWindowTitle(const char *title)
 {
-    SDL_SetWindowTitle(TXT_SDLWindow, title);
+    if (TXT_SDLWindow != NULL)
+    {
+        SDL_SetWindowTitle(TXT_SDLWindow, title);
+    }
+    else if (backend == TXT_BACKEND_TERMINAL)
+    {
+        TXT_Term_SetWindowTitle(title);
+    }
 }
 
 void TXT_SDL_SetEventCallback(TxtSDLEventCallbackFunc callback, void *user_data)
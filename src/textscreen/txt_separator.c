@@ -58,9 +58,9 @@ static void TXT_SeparatorDrawer(TXT_UNCAST_ARG(separator))
         TXT_GotoXY(x, y);
 
         TXT_FGColor(TXT_COLOR_BRIGHT_GREEN);
-        TXT_DrawString(" ");
+        TXT_FillSpan(' ', 1);
         TXT_DrawString(separator->label);
-        TXT_DrawString(" ");
+        TXT_FillSpan(' ', 1);
     }
 }
 
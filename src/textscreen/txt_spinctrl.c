@@ -151,8 +151,7 @@ static void SetBuffer(txt_spincontrol_t *spincontrol)
 static void TXT_SpinControlDrawer(TXT_UNCAST_ARG(spincontrol))
 {
     TXT_CAST_ARG(txt_spincontrol_t, spincontrol);
-    unsigned int i;
-    unsigned int padding;
+    int padding;
     txt_saved_colors_t colors;
     int bw;
     int focused;
@@ -182,25 +181,11 @@ static void TXT_SpinControlDrawer(TXT_UNCAST_ARG(spincontrol))
         SetBuffer(spincontrol);
     }
 
-    i = 0;
-
     bw = TXT_UTF8_Strlen(spincontrol->buffer);
     padding = spincontrol->widget.w - bw - 4;
 
-    while (i < padding)
-    {
-        TXT_DrawString(" ");
-        ++i;
-    }
-
+    TXT_FillSpan(' ', padding);
     TXT_DrawString(spincontrol->buffer);
-    i += bw;
-
-    while (i < spincontrol->widget.w - 4)
-    {
-        TXT_DrawString(" ");
-        ++i;
-    }
 
     TXT_RestoreColors(&colors);
     TXT_FGColor(TXT_COLOR_BRIGHT_CYAN);
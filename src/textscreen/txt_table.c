@@ -19,8 +19,10 @@
 #include "doomkeys.h"
 #include "txt_desktop.h"
 #include "txt_gui.h"
+#include "txt_hittest.h"
 #include "txt_io.h"
 #include "txt_main.h"
+#include "txt_perf.h"
 #include "txt_separator.h"
 #include "txt_strut.h"
 #include "txt_table.h"
@@ -39,6 +41,13 @@ static int IsActualWidget(txt_widget_t *widget)
         && widget != &txt_table_overflow_down;
 }
 
+// Hidden widgets take up no space and are not drawn.
+
+static int IsShownWidget(txt_widget_t *widget)
+{
+    return IsActualWidget(widget) && widget->visible;
+}
+
 // Remove all entries from a table
 
 void TXT_ClearTable(TXT_UNCAST_ARG(table))
@@ -191,7 +200,7 @@ static void CalcRowColSizes(txt_table_t *table,
 
             widget = table->widgets[y * table->columns + x];
 
-            if (IsActualWidget(widget))
+            if (IsShownWidget(widget))
             {
                 TXT_CalcWidgetSize(widget);
             }
@@ -203,7 +212,7 @@ static void CalcRowColSizes(txt_table_t *table,
             }
 
             // NULL represents an empty spacer
-            if (IsActualWidget(widget))
+            if (IsShownWidget(widget))
             {
                 if (widget->h > row_heights[y])
                     row_heights[y] = widget->h;
@@ -225,7 +234,7 @@ static void CalcRowColSizes(txt_table_t *table,
                 break;
 
             widget = table->widgets[y * table->columns + x];
-            if (!IsActualWidget(widget))
+            if (!IsShownWidget(widget))
             {
                 continue;
             }
@@ -257,6 +266,7 @@ static void TXT_CalcTableSize(TXT_UNCAST_ARG(table))
 
     row_heights = malloc(sizeof(int) * rows);
     column_widths = malloc(sizeof(int) * table->columns);
+    TXT_PerfCount(TXT_PERF_ALLOCS, 2);
 
     CalcRowColSizes(table, row_heights, column_widths);
 
@@ -515,7 +525,7 @@ static int TXT_TableKeyPress(TXT_UNCAST_ARG(table), int key)
              i >= 0 && i < table->num_widgets;
              i += dir)
         {
-            if (IsActualWidget(table->widgets[i])
+            if (IsShownWidget(table->widgets[i])
              && TXT_SelectableWidget(table->widgets[i]))
             {
                 ChangeSelection(table, i % table->columns, i / table->columns);
@@ -700,6 +710,7 @@ static void TXT_TableLayout(TXT_UNCAST_ARG(table))
 
     column_widths = malloc(sizeof(int) * table->columns);
     row_heights = malloc(sizeof(int) * rows);
+    TXT_PerfCount(TXT_PERF_ALLOCS, 2);
 
     CalcRowColSizes(table, row_heights, column_widths);
 
@@ -729,7 +740,7 @@ static void TXT_TableLayout(TXT_UNCAST_ARG(table))
 
             widget = table->widgets[i];
 
-            if (IsActualWidget(widget))
+            if (IsShownWidget(widget))
             {
                 CalculateWidgetDimensions(table, x, y,
                                           column_widths, row_heights,
@@ -764,7 +775,7 @@ static void TXT_TableDrawer(TXT_UNCAST_ARG(table))
     {
         widget = table->widgets[i];
 
-        if (IsActualWidget(widget))
+        if (IsShownWidget(widget))
         {
             TXT_GotoXY(widget->x, widget->y);
             TXT_DrawWidget(widget);
@@ -777,38 +788,55 @@ static void TXT_TableDrawer(TXT_UNCAST_ARG(table))
 static void TXT_TableMousePress(TXT_UNCAST_ARG(table), int x, int y, int b)
 {
     TXT_CAST_ARG(txt_table_t, table);
+    txt_window_t *active_window;
     txt_widget_t *widget;
     int i;
 
-    for (i=0; i<table->num_widgets; ++i)
+    // Find the widget that was clicked, then the cell of ours that it is
+    // in.
+
+    active_window = TXT_GetActiveWindow();
+
+    if (active_window == NULL)
     {
-        widget = table->widgets[i];
+        return;
+    }
 
-        // NULL widgets are spacers
+    widget = TXT_HitTest(active_window->hit_index, x, y);
 
-        if (IsActualWidget(widget))
-        {
-            if (x >= widget->x && x < (signed) (widget->x + widget->w)
-             && y >= widget->y && y < (signed) (widget->y + widget->h))
-            {
-                // This is the widget that was clicked!
+    while (widget != NULL && widget->parent != &table->widget)
+    {
+        widget = widget->parent;
+    }
 
-                // Select the cell if the widget is selectable
+    if (widget == NULL)
+    {
+        return;
+    }
 
-                if (TXT_SelectableWidget(widget))
-                {
-                    ChangeSelection(table, i % table->columns,
-                                           i / table->columns);
-                }
+    for (i=0; i<table->num_widgets; ++i)
+    {
+        if (table->widgets[i] == widget)
+        {
+            break;
+        }
+    }
 
-                // Propagate click
+    if (i >= table->num_widgets)
+    {
+        return;
+    }
 
-                TXT_WidgetMousePress(widget, x, y, b);
+    // Select the cell if the widget is selectable
 
-                break;
-            }
-        }
+    if (TXT_SelectableWidget(widget))
+    {
+        ChangeSelection(table, i % table->columns, i / table->columns);
     }
+
+    // Propagate click
+
+    TXT_WidgetMousePress(widget, x, y, b);
 }
 
 // Determine whether the table is selectable.
@@ -829,7 +857,7 @@ static int TXT_TableSelectable(TXT_UNCAST_ARG(table))
 
     for (i = 0; i < table->num_widgets; ++i)
     {
-        if (IsActualWidget(table->widgets[i])
+        if (IsShownWidget(table->widgets[i])
          && TXT_SelectableWidget(table->widgets[i]))
         {
             ChangeSelection(table, i % table->columns, i / table->columns);
@@ -1175,6 +1203,7 @@ int TXT_PageTable(TXT_UNCAST_ARG(table), int pagex, int pagey)
 
     row_heights = malloc(sizeof(int) * rows);
     column_widths = malloc(sizeof(int) * table->columns);
+    TXT_PerfCount(TXT_PERF_ALLOCS, 2);
 
     CalcRowColSizes(table, row_heights, column_widths);
 
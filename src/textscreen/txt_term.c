@@ -0,0 +1,861 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Text mode emulation on a VT100/xterm-compatible terminal, for use over
+// a remote shell. Only the characters that have changed since the last
+// update are sent, with as little cursor movement as we can manage.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "doomkeys.h"
+#include "txt_main.h"
+#include "txt_term.h"
+#include "txt_utf8.h"
+
+#include "fonts/codepage.h"
+
+#define arrlen(array) (sizeof(array) / sizeof(*array))
+
+#ifndef _WIN32
+
+// Unchanged characters between two changes are sent again if there are
+// no more than this many of them, as that is cheaper than moving over them.
+
+#define MAX_RUN_GAP 4
+
+// How long to wait for the rest of an escape sequence before deciding
+// that the escape key was pressed on its own, in ms.
+
+#define ESCAPE_DELAY 25
+
+// Returned by the input parser when more bytes are needed.
+
+#define INCOMPLETE (-2)
+
+static const short code_page_to_unicode[] = CODE_PAGE_TO_UNICODE;
+
+// ANSI color numbers for the first eight EGA colors; the other eight are
+// the bright versions of these.
+
+static const int ega_to_ansi[] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+static unsigned char term_palette[16][3] =
+{
+    {0x00, 0x00, 0x00}, {0x00, 0x00, 0xa8}, {0x00, 0xa8, 0x00},
+    {0x00, 0xa8, 0xa8}, {0xa8, 0x00, 0x00}, {0xa8, 0x00, 0xa8},
+    {0xa8, 0x54, 0x00}, {0xa8, 0xa8, 0xa8}, {0x54, 0x54, 0x54},
+    {0x54, 0x54, 0xfe}, {0x54, 0xfe, 0x54}, {0x54, 0xfe, 0xfe},
+    {0xfe, 0x54, 0x54}, {0xfe, 0x54, 0xfe}, {0xfe, 0xfe, 0x54},
+    {0xfe, 0xfe, 0xfe},
+};
+
+static struct termios saved_termios;
+static int term_active = 0;
+static int truecolor;
+static volatile sig_atomic_t resized;
+
+// The screen as last sent to the terminal.
+
+static unsigned char sentscreendata[TXT_SCREEN_W * TXT_SCREEN_H * 2];
+static int sent_valid;
+
+// Where the terminal's cursor is and what attribute it is drawing with,
+// as far as we know; -1 when we do not know.
+
+static int cursor_x, cursor_y;
+static int current_attr;
+
+static int mouse_x, mouse_y;
+
+// Output is gathered here and written all at once.
+
+static char outbuf[16384];
+static size_t outbuf_len;
+static unsigned int bytes_written;
+
+static unsigned char inbuf[256];
+static size_t inbuf_len;
+
+// Other threads write to this pipe to wake the main loop while it waits
+// for input. It is kept open once made, so that it can't be closed under
+// a thread writing to it.
+
+static int wake_fds[2] = { -1, -1 };
+
+static void Flush(void)
+{
+    size_t pos = 0;
+
+    while (pos < outbuf_len)
+    {
+        ssize_t n = write(STDOUT_FILENO, outbuf + pos, outbuf_len - pos);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        pos += n;
+    }
+
+    bytes_written += outbuf_len;
+    outbuf_len = 0;
+}
+
+static void Put(const char *s, size_t len)
+{
+    if (outbuf_len + len > sizeof(outbuf))
+    {
+        Flush();
+    }
+
+    memcpy(outbuf + outbuf_len, s, len);
+    outbuf_len += len;
+}
+
+static void PutString(const char *s)
+{
+    Put(s, strlen(s));
+}
+
+static void MoveCursor(int x, int y)
+{
+    char best[24], candidate[24];
+
+    if (x == cursor_x && y == cursor_y)
+    {
+        return;
+    }
+
+    // An absolute position always works; look for something shorter.
+
+    TXT_snprintf(best, sizeof(best), "\x1b[%d;%dH", y + 1, x + 1);
+
+    if (cursor_x >= 0 && y == cursor_y)
+    {
+        if (x > cursor_x)
+        {
+            TXT_snprintf(candidate, sizeof(candidate), "\x1b[%dC",
+                         x - cursor_x);
+        }
+        else
+        {
+            TXT_snprintf(candidate, sizeof(candidate), "\x1b[%dD",
+                         cursor_x - x);
+        }
+
+        if (strlen(candidate) < strlen(best))
+        {
+            TXT_StringCopy(best, candidate, sizeof(best));
+        }
+    }
+
+    if (cursor_y >= 0 && (y == cursor_y || y == cursor_y + 1))
+    {
+        // Back to the start of the line (and down one), then along.
+
+        TXT_StringCopy(candidate, y == cursor_y ? "\r" : "\r\x1b[B",
+                       sizeof(candidate));
+
+        if (x > 0)
+        {
+            size_t len = strlen(candidate);
+            TXT_snprintf(candidate + len, sizeof(candidate) - len,
+                         "\x1b[%dC", x);
+        }
+
+        if (strlen(candidate) < strlen(best))
+        {
+            TXT_StringCopy(best, candidate, sizeof(best));
+        }
+    }
+
+    PutString(best);
+    cursor_x = x;
+    cursor_y = y;
+}
+
+static int ANSIColor(int color)
+{
+    return ega_to_ansi[color & 7] + ((color & 8) ? 60 : 0);
+}
+
+static void SetAttribute(int attr)
+{
+    char buf[64];
+    size_t len = 0;
+    int fg, bg;
+
+    if (attr == current_attr)
+    {
+        return;
+    }
+
+    fg = attr & 0xf;
+    bg = (attr >> 4) & 0x7;
+
+    buf[len++] = '\x1b';
+    buf[len++] = '[';
+
+    // Only what has changed, unless we do not know what is set.
+
+    if (current_attr < 0)
+    {
+        buf[len++] = '0';
+    }
+    if (current_attr < 0 || ((attr ^ current_attr) & 0x80) != 0)
+    {
+        len += TXT_snprintf(buf + len, sizeof(buf) - len, "%s%s",
+                            len > 2 ? ";" : "", (attr & 0x80) ? "5" : "25");
+    }
+    if (current_attr < 0 || fg != (current_attr & 0xf))
+    {
+        if (truecolor)
+        {
+            len += TXT_snprintf(buf + len, sizeof(buf) - len,
+                                "%s38;2;%d;%d;%d", len > 2 ? ";" : "",
+                                term_palette[fg][0], term_palette[fg][1],
+                                term_palette[fg][2]);
+        }
+        else
+        {
+            len += TXT_snprintf(buf + len, sizeof(buf) - len, "%s%d",
+                                len > 2 ? ";" : "", 30 + ANSIColor(fg));
+        }
+    }
+    if (current_attr < 0 || bg != ((current_attr >> 4) & 0x7))
+    {
+        if (truecolor)
+        {
+            len += TXT_snprintf(buf + len, sizeof(buf) - len,
+                                "%s48;2;%d;%d;%d", len > 2 ? ";" : "",
+                                term_palette[bg][0], term_palette[bg][1],
+                                term_palette[bg][2]);
+        }
+        else
+        {
+            len += TXT_snprintf(buf + len, sizeof(buf) - len, "%s%d",
+                                len > 2 ? ";" : "", 40 + ANSIColor(bg));
+        }
+    }
+
+    buf[len++] = 'm';
+    Put(buf, len);
+
+    current_attr = attr;
+}
+
+static void PutCell(unsigned char c, unsigned char attr)
+{
+    char buf[8];
+    char *end;
+    unsigned int u;
+
+    SetAttribute(attr);
+
+    u = (unsigned short) code_page_to_unicode[c];
+    end = TXT_EncodeUTF8(buf, u != 0 ? u : ' ');
+    Put(buf, end - buf);
+
+    // Autowrap is off, so the cursor stops at the right edge; but some
+    // terminals then leave it in a state we cannot rely on.
+
+    ++cursor_x;
+    if (cursor_x >= TXT_SCREEN_W)
+    {
+        cursor_x = -1;
+        cursor_y = -1;
+    }
+}
+
+static int CellChanged(const unsigned char *screendata, int i)
+{
+    return !sent_valid
+        || screendata[i * 2] != sentscreendata[i * 2]
+        || screendata[i * 2 + 1] != sentscreendata[i * 2 + 1];
+}
+
+unsigned int TXT_Term_UpdateScreen(const unsigned char *screendata)
+{
+    int x, y, x1, end, gap;
+
+    if (!term_active)
+    {
+        return 0;
+    }
+
+    bytes_written = 0;
+
+    if (resized)
+    {
+        // Whatever the terminal did with the old contents, start again.
+
+        resized = 0;
+        PutString("\x1b[0m\x1b[2J");
+        sent_valid = 0;
+        current_attr = -1;
+        cursor_x = cursor_y = -1;
+    }
+
+    for (y = 0; y < TXT_SCREEN_H; ++y)
+    {
+        x = 0;
+
+        while (x < TXT_SCREEN_W)
+        {
+            if (!CellChanged(screendata, y * TXT_SCREEN_W + x))
+            {
+                ++x;
+                continue;
+            }
+
+            // Find the end of this run of changes, carrying on over
+            // short gaps.
+
+            end = x + 1;
+            gap = 0;
+
+            for (x1 = x + 1; x1 < TXT_SCREEN_W; ++x1)
+            {
+                if (CellChanged(screendata, y * TXT_SCREEN_W + x1))
+                {
+                    end = x1 + 1;
+                    gap = 0;
+                }
+                else if (++gap > MAX_RUN_GAP)
+                {
+                    break;
+                }
+            }
+
+            MoveCursor(x, y);
+
+            for (x1 = x; x1 < end; ++x1)
+            {
+                int i = (y * TXT_SCREEN_W + x1) * 2;
+
+                PutCell(screendata[i], screendata[i + 1]);
+                sentscreendata[i] = screendata[i];
+                sentscreendata[i + 1] = screendata[i + 1];
+            }
+
+            x = end;
+        }
+    }
+
+    sent_valid = 1;
+    Flush();
+
+    return bytes_written;
+}
+
+void TXT_Term_SetColor(int color, int r, int g, int b)
+{
+    term_palette[color][0] = r;
+    term_palette[color][1] = g;
+    term_palette[color][2] = b;
+
+    // Everything drawn in that color must be sent again.
+
+    if (truecolor)
+    {
+        sent_valid = 0;
+        current_attr = -1;
+    }
+}
+
+static void HandleResize(int sig)
+{
+    resized = 1;
+}
+
+static void InitWakePipe(void)
+{
+    int i;
+
+    if (wake_fds[0] >= 0 || pipe(wake_fds) != 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < 2; ++i)
+    {
+        fcntl(wake_fds[i], F_SETFL, fcntl(wake_fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+}
+
+int TXT_Term_Init(void)
+{
+    struct termios raw;
+    struct sigaction sa;
+    struct winsize ws;
+    const char *colorterm;
+    static int atexit_set = 0;
+
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)
+     || tcgetattr(STDIN_FILENO, &saved_termios) != 0)
+    {
+        return 0;
+    }
+
+    // The screen can't be drawn on a terminal smaller than it.
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0
+     && ws.ws_col > 0 && ws.ws_row > 0
+     && (ws.ws_col < TXT_SCREEN_W || ws.ws_row < TXT_SCREEN_H))
+    {
+        fprintf(stderr, "The terminal is %ix%i; it must be at least %ix%i.\n",
+                ws.ws_col, ws.ws_row, TXT_SCREEN_W, TXT_SCREEN_H);
+        return 0;
+    }
+
+    raw = saved_termios;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~OPOST;
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0)
+    {
+        return 0;
+    }
+
+    colorterm = getenv("COLORTERM");
+    truecolor = colorterm != NULL
+             && (!strcmp(colorterm, "truecolor") || !strcmp(colorterm, "24bit"));
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = HandleResize;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGWINCH, &sa, NULL);
+
+    InitWakePipe();
+
+    term_active = 1;
+    sent_valid = 0;
+    current_attr = -1;
+    cursor_x = cursor_y = -1;
+    inbuf_len = 0;
+
+    // Alternate screen, hidden cursor, no autowrap, and mouse clicks
+    // reported as SGR sequences.
+
+    PutString("\x1b[?1049h\x1b[?25l\x1b[?7l\x1b[0m\x1b[2J"
+              "\x1b[?1000h\x1b[?1006h");
+    Flush();
+
+    // Make sure the terminal is usable again however we exit.
+
+    if (!atexit_set)
+    {
+        atexit(TXT_Term_Shutdown);
+        atexit_set = 1;
+    }
+
+    return 1;
+}
+
+void TXT_Term_Shutdown(void)
+{
+    if (!term_active)
+    {
+        return;
+    }
+
+    PutString("\x1b[?1006l\x1b[?1000l\x1b[0m\x1b[?7h\x1b[?25h\x1b[?1049l");
+    Flush();
+
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+    signal(SIGWINCH, SIG_DFL);
+    term_active = 0;
+}
+
+static int WaitForInput(int timeout)
+{
+    struct pollfd pfd;
+
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    return poll(&pfd, 1, timeout) > 0;
+}
+
+static void ReadInput(void)
+{
+    ssize_t n;
+
+    if (inbuf_len < sizeof(inbuf))
+    {
+        n = read(STDIN_FILENO, inbuf + inbuf_len, sizeof(inbuf) - inbuf_len);
+
+        if (n > 0)
+        {
+            inbuf_len += n;
+        }
+    }
+}
+
+static void Consume(size_t n)
+{
+    memmove(inbuf, inbuf + n, inbuf_len - n);
+    inbuf_len -= n;
+}
+
+// Keys for "CSI n ~" sequences, indexed by n.
+
+static const int tilde_keys[] =
+{
+    0,       KEY_HOME, KEY_INS,  KEY_DEL,   KEY_END,   KEY_PGUP,  // 0-5
+    KEY_PGDN, KEY_HOME, KEY_END, 0,         0,         KEY_F1,    // 6-11
+    KEY_F2,  KEY_F3,   KEY_F4,   KEY_F5,    0,         KEY_F6,    // 12-17
+    KEY_F7,  KEY_F8,   KEY_F9,   KEY_F10,   0,         KEY_F11,   // 18-23
+    KEY_F12,                                                      // 24
+};
+
+// Keys for the final character of "CSI x" and "SS3 x" sequences.
+
+static int FinalKey(int c)
+{
+    switch (c)
+    {
+        case 'A': return KEY_UPARROW;
+        case 'B': return KEY_DOWNARROW;
+        case 'C': return KEY_RIGHTARROW;
+        case 'D': return KEY_LEFTARROW;
+        case 'H': return KEY_HOME;
+        case 'F': return KEY_END;
+        case 'M': return KEY_ENTER;
+        case 'P': return KEY_F1;
+        case 'Q': return KEY_F2;
+        case 'R': return KEY_F3;
+        case 'S': return KEY_F4;
+        default:  return 0;
+    }
+}
+
+// An SGR mouse report: "CSI < button ; x ; y M" for a press, or with
+// a final 'm' for a release.
+
+static int MouseKey(const char *params, int final)
+{
+    int button, x, y;
+
+    if (sscanf(params, "<%d;%d;%d", &button, &x, &y) != 3)
+    {
+        return 0;
+    }
+
+    mouse_x = x - 1;
+    mouse_y = y - 1;
+
+    if (final != 'M')
+    {
+        return 0;
+    }
+
+    // Ignore the modifier bits.
+
+    switch (button & ~(4 | 8 | 16))
+    {
+        case 0:  return TXT_MOUSE_LEFT;
+        case 1:  return TXT_MOUSE_MIDDLE;
+        case 2:  return TXT_MOUSE_RIGHT;
+        case 64: return TXT_MOUSE_SCROLLUP;
+        case 65: return TXT_MOUSE_SCROLLDOWN;
+        default: return 0;
+    }
+}
+
+static int ParseEscape(void)
+{
+    char params[32];
+    size_t i, len;
+    int final, key;
+
+    if (inbuf_len < 2)
+    {
+        return INCOMPLETE;
+    }
+
+    if (inbuf[1] == 'O')
+    {
+        // SS3, sent for some keys in application mode.
+
+        if (inbuf_len < 3)
+        {
+            return INCOMPLETE;
+        }
+
+        key = FinalKey(inbuf[2]);
+        Consume(3);
+        return key;
+    }
+    else if (inbuf[1] != '[')
+    {
+        // Alt and a key, or two escapes; either way, an escape.
+
+        Consume(1);
+        return KEY_ESCAPE;
+    }
+
+    // CSI: parameters up to a final character.
+
+    for (i = 2; i < inbuf_len; ++i)
+    {
+        if (inbuf[i] >= 0x40 && inbuf[i] <= 0x7e)
+        {
+            break;
+        }
+    }
+
+    if (i == inbuf_len)
+    {
+        return i < sizeof(inbuf) ? INCOMPLETE : 0;
+    }
+
+    final = inbuf[i];
+    len = i - 2 < sizeof(params) ? i - 2 : sizeof(params) - 1;
+    memcpy(params, inbuf + 2, len);
+    params[len] = '\0';
+    Consume(i + 1);
+
+    if (params[0] == '<')
+    {
+        return MouseKey(params, final);
+    }
+    else if (final == '~')
+    {
+        int n = atoi(params);
+
+        return n >= 0 && n < (int) arrlen(tilde_keys) ? tilde_keys[n] : 0;
+    }
+    else
+    {
+        return FinalKey(final);
+    }
+}
+
+static int ParseInput(void)
+{
+    unsigned char c = inbuf[0];
+
+    if (c == '\x1b')
+    {
+        return ParseEscape();
+    }
+    else if (c >= 0x80)
+    {
+        char buf[5];
+        const char *p = buf;
+        unsigned int u;
+        size_t len = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+
+        if (inbuf_len < len)
+        {
+            return INCOMPLETE;
+        }
+
+        memcpy(buf, inbuf, len);
+        buf[len] = '\0';
+        Consume(len);
+
+        u = TXT_DecodeUTF8(&p);
+
+        return TXT_UNICODE_TO_KEY(u);
+    }
+
+    Consume(1);
+
+    switch (c)
+    {
+        case '\r':
+        case '\n':
+            return KEY_ENTER;
+
+        case '\b':
+        case 0x7f:
+            return KEY_BACKSPACE;
+
+        case 'L' & 0x1f:
+            // Ctrl-L: send the whole screen again.
+            sent_valid = 0;
+            current_attr = -1;
+            cursor_x = cursor_y = -1;
+            return 0;
+
+        default:
+            return c;
+    }
+}
+
+int TXT_Term_GetChar(void)
+{
+    int key;
+
+    for (;;)
+    {
+        ReadInput();
+
+        if (inbuf_len == 0)
+        {
+            return -1;
+        }
+
+        key = ParseInput();
+
+        if (key == INCOMPLETE)
+        {
+            // Wait a little for the rest of it to arrive.
+
+            if (WaitForInput(ESCAPE_DELAY))
+            {
+                continue;
+            }
+
+            if (inbuf[0] == '\x1b' && inbuf_len == 1)
+            {
+                Consume(1);
+                return KEY_ESCAPE;
+            }
+
+            inbuf_len = 0;
+            return -1;
+        }
+
+        return key;
+    }
+}
+
+void TXT_Term_GetMousePosition(int *x, int *y)
+{
+    *x = mouse_x;
+    *y = mouse_y;
+}
+
+void TXT_Term_Sleep(int timeout)
+{
+    struct pollfd pfd[2];
+    char buf[64];
+
+    if (inbuf_len > 0)
+    {
+        return;
+    }
+
+    pfd[0].fd = STDIN_FILENO;
+    pfd[0].events = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd = wake_fds[0];
+    pfd[1].events = POLLIN;
+    pfd[1].revents = 0;
+
+    poll(pfd, wake_fds[0] >= 0 ? 2 : 1, timeout != 0 ? timeout : -1);
+
+    if (pfd[1].revents & POLLIN)
+    {
+        while (read(wake_fds[0], buf, sizeof(buf)) > 0);
+    }
+}
+
+void TXT_Term_Wake(void)
+{
+    char c = 0;
+
+    if (wake_fds[1] >= 0 && write(wake_fds[1], &c, 1) < 0)
+    {
+        // Pipe is full, so the main loop will wake up anyway.
+    }
+}
+
+void TXT_Term_SetWindowTitle(const char *title)
+{
+    if (!term_active)
+    {
+        return;
+    }
+
+    PutString("\x1b]0;");
+    PutString(title);
+    PutString("\x07");
+    Flush();
+}
+
+#else
+
+// Not yet available on Windows.
+
+int TXT_Term_Init(void)
+{
+    return 0;
+}
+
+void TXT_Term_Shutdown(void)
+{
+}
+
+unsigned int TXT_Term_UpdateScreen(const unsigned char *screendata)
+{
+    return 0;
+}
+
+void TXT_Term_SetColor(int color, int r, int g, int b)
+{
+}
+
+int TXT_Term_GetChar(void)
+{
+    return -1;
+}
+
+void TXT_Term_GetMousePosition(int *x, int *y)
+{
+    *x = 0;
+    *y = 0;
+}
+
+void TXT_Term_Sleep(int timeout)
+{
+}
+
+void TXT_Term_Wake(void)
+{
+}
+
+void TXT_Term_SetWindowTitle(const char *title)
+{
+}
+
+#endif
@@ -0,0 +1,57 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+
+//
+// Text mode emulation on a VT100/xterm-compatible terminal
+//
+
+#ifndef TXT_TERM_H
+#define TXT_TERM_H
+
+// These implement the TXT_BACKEND_TERMINAL side of the functions in
+// txt_main.h, and are called from txt_sdl.c, except for TXT_Term_Wake().
+
+// Take over the terminal on standard input and output.
+// Returns 1 if successful, 0 if they are not a terminal or it is too small.
+int TXT_Term_Init(void);
+
+// Give the terminal back as it was.
+void TXT_Term_Shutdown(void);
+
+// Send the changes to the screen since it was last sent. Returns the
+// number of bytes written.
+unsigned int TXT_Term_UpdateScreen(const unsigned char *screendata);
+
+// Set the RGB value for a palette entry, used on terminals that can
+// show any color.
+void TXT_Term_SetColor(int color, int r, int g, int b);
+
+// Read a key from the terminal, or return -1 if there is none.
+int TXT_Term_GetChar(void);
+
+// Position of the mouse at the last click.
+void TXT_Term_GetMousePosition(int *x, int *y);
+
+// Wait until there is input, TXT_Term_Wake() is called, or the timeout
+// (in ms, 0 for none) expires.
+void TXT_Term_Sleep(int timeout);
+
+// Wake TXT_Term_Sleep() early. The SDL events that wake the main loop are
+// not delivered while the terminal is used, so code that pushes them
+// must call this too. Can be called from any thread.
+void TXT_Term_Wake(void);
+
+void TXT_Term_SetWindowTitle(const char *title);
+
+#endif /* #ifndef TXT_TERM_H */
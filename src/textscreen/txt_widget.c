@@ -17,6 +17,7 @@
 #include "txt_widget.h"
 #include "txt_gui.h"
 #include "txt_desktop.h"
+#include "txt_hittest.h"
 
 typedef struct
 {
@@ -233,6 +234,8 @@ void TXT_LayoutWidget(TXT_UNCAST_ARG(widget))
 {
     TXT_CAST_ARG(txt_widget_t, widget);
 
+    TXT_AddHitWidget(widget);
+
     if (widget->widget_class->layout != NULL)
     {
         widget->widget_class->layout(widget);
@@ -285,23 +288,40 @@ int TXT_HoveringOverWidget(TXT_UNCAST_ARG(widget))
 {
     TXT_CAST_ARG(txt_widget_t, widget);
     txt_window_t *active_window;
+    txt_widget_t *hit;
     int x, y;
 
     // We can only be hovering over widgets in the active window.
 
     active_window = TXT_GetActiveWindow();
 
-    if (active_window == NULL || !TXT_ContainsWidget(active_window, widget))
+    if (active_window == NULL)
     {
         return 0;
     }
 
-    // Is the mouse cursor within the bounds of the widget?
-
     TXT_GetMousePosition(&x, &y);
+    hit = TXT_HitTest(active_window->hit_index, x, y);
+
+    if (hit == NULL)
+    {
+        return 0;
+    }
+
+    // The widget under the cursor, or one inside it?
+
+    if (TXT_ContainsWidget(widget, hit))
+    {
+        return 1;
+    }
+
+    // Some widgets position the widgets inside them while drawing rather
+    // than when they are laid out; those are not in the index, so check
+    // them against the bounds of the widget.
 
-    return (x >= widget->x && (unsigned int)x < widget->x + widget->w
-         && y >= widget->y && (unsigned int)y < widget->y + widget->h);
+    return TXT_ContainsWidget(hit, widget)
+        && x >= widget->x && (unsigned int)x < widget->x + widget->w
+        && y >= widget->y && (unsigned int)y < widget->y + widget->h;
 }
 
 void TXT_SetWidgetBG(TXT_UNCAST_ARG(widget))
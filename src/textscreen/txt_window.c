@@ -16,10 +16,12 @@
 #include "txt_label.h"
 #include "txt_desktop.h"
 #include "txt_gui.h"
+#include "txt_hittest.h"
 #include "txt_io.h"
 #include "txt_main.h"
 #include "txt_separator.h"
 #include "txt_window.h"
+#include "../elib/trace.h"
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -69,6 +71,11 @@ txt_window_t *TXT_NewWindow(const char *title)
 
     win->x = TXT_SCREEN_W / 2;
     win->y = TXT_SCREEN_H / 2;
+    win->desktop_link.next = NULL;
+    win->desktop_link.prev = NULL;
+    win->desktop_link.object = win;
+    win->desktop_link.data = 0;
+    win->hit_index = NULL;
     win->horiz_align = TXT_HORIZ_CENTER;
     win->vert_align = TXT_VERT_CENTER;
     win->key_listener = NULL;
@@ -100,6 +107,7 @@ void TXT_CloseWindow(txt_window_t *window)
     TXT_RemoveDesktopWindow(window);
 
     free(window->title);
+    TXT_FreeHitIndex(window->hit_index);
 
     // Destroy all actions
 
@@ -262,6 +270,8 @@ void TXT_LayoutWindow(txt_window_t *window)
     unsigned int widgets_w;
     unsigned int actionarea_w, actionarea_h;
 
+    TRACE_BEGIN(trace);
+
     // Calculate size of table
     
     TXT_CalcWidgetSize(window);
@@ -313,17 +323,25 @@ void TXT_LayoutWindow(txt_window_t *window)
         widgets->y += 2;
     }
 
-    // Layout the table and action area
+    // Layout the table and action area, noting where their widgets are
 
+    TXT_BeginHitIndex(&window->hit_index, widgets);
     LayoutActionArea(window);
     TXT_LayoutWidget(widgets);
+    TXT_EndHitIndex();
+
+    TRACE_END(trace, "TXT_LayoutWindow");
 }
 
 void TXT_DrawWindow(txt_window_t *window)
 {
-    txt_widget_t *widgets;
-
     TXT_LayoutWindow(window);
+    TXT_DrawLaidOutWindow(window);
+}
+
+void TXT_DrawLaidOutWindow(txt_window_t *window)
+{
+    txt_widget_t *widgets;
 
     if (window->table.widget.focused)
     {
@@ -378,7 +396,7 @@ static int MouseButtonPress(txt_window_t *window, int b)
 {
     int x, y;
     int i;
-    txt_widget_t *widgets;
+    txt_widget_t *hit;
     txt_widget_t *widget;
 
     // Lay out the window, set positions and sizes of all widgets
@@ -403,15 +421,13 @@ static int MouseButtonPress(txt_window_t *window, int b)
         }
     }
 
-    // Is it within the table range?
+    // Which widget is under the mouse?
 
-    widgets = (txt_widget_t *) window;
+    hit = TXT_HitTest(window->hit_index, x, y);
 
-    if (x >= widgets->x && x < (signed) (widgets->x + widgets->w)
-     && y >= widgets->y && y < (signed) (widgets->y + widgets->h))
+    if (hit == NULL)
     {
-        TXT_WidgetMousePress(window, x, y, b);
-        return 1;
+        return 0;
     }
 
     // Was one of the action area buttons pressed?
@@ -420,9 +436,7 @@ static int MouseButtonPress(txt_window_t *window, int b)
     {
         widget = window->actions[i];
 
-        if (widget != NULL
-         && x >= widget->x && x < (signed) (widget->x + widget->w)
-         && y >= widget->y && y < (signed) (widget->y + widget->h))
+        if (widget != NULL && TXT_ContainsWidget(widget, hit))
         {
             int was_focused;
 
@@ -442,7 +456,10 @@ static int MouseButtonPress(txt_window_t *window, int b)
         }
     }
 
-    return 0;
+    // Otherwise it is within the table.
+
+    TXT_WidgetMousePress(window, x, y, b);
+    return 1;
 }
 
 int TXT_WindowKeyPress(txt_window_t *window, int c)
@@ -54,6 +54,17 @@ typedef int (*TxtWindowMousePress)(txt_window_t *window,
                                    int x, int y, int b,
                                    void *user_data);
 
+// Link in the desktop's stack of windows. The desktop uses this as a
+// DLListItem<txt_window_t> from elib/dllist.h, which it matches in layout.
+
+typedef struct txt_window_link_s
+{
+    struct txt_window_link_s *next;
+    struct txt_window_link_s **prev;
+    txt_window_t *object;
+    unsigned int data;
+} txt_window_link_t;
+
 struct txt_window_s
 {
     // Base class: all windows are tables with one column.
@@ -89,6 +100,15 @@ struct txt_window_s
     // URL of a webpage with help about this window. If set, a help key
     // indicator is shown while this window is active.
     const char *help_url;
+
+    // Position in the desktop's stack of windows, if it is on it.
+
+    txt_window_link_t desktop_link;
+
+    // Where the widgets are on the screen, for mouse input. This is
+    // rebuilt when the window is laid out.
+
+    struct txt_hit_index_s *hit_index;
 };
 
 /**
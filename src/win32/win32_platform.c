@@ -34,6 +34,7 @@
 #include <Windows.h>
 //#include "../../vc2015/resource.h"
 
+#include "../elib/log.h"
 #include "../elib/misc.h"
 #include "../hal/hal_ml.h"
 #include "../hal/hal_platform.h"
@@ -46,10 +47,20 @@
 static void Win32_DebugMsg(const char *msg, ...)
 {
 #ifdef _DEBUG
-   va_list args;
    static BOOL debugInit = FALSE;
    size_t len = strlen(msg);
+#endif
+   va_list args;
 
+   if(e_logLevel <= LOGLEVEL_INFO)
+   {
+      va_start(args, msg);
+      E_LogV(LOGLEVEL_INFO, "debug", msg, args);
+      va_end(args);
+      return;
+   }
+
+#ifdef _DEBUG
    if(!debugInit)
    {
       if(AllocConsole())